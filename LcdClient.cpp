@@ -1,15 +1,63 @@
 #include "LcdClient.hpp"
 
+#include <algorithm>
+
+// Maximum number of entries in one group menu of the main menu
+static const int mainMenuPageSize = 8;
+
+// First (or last) interface below an entry of a group menu, an interface is its own
+static QString edgeInterface(const QHash<QString, QStringList> &members, QString id, bool last)
+{
+    while (id.startsWith("_grp_") && !members.value(id).isEmpty()) {
+        id = last ? members.value(id).last() : members.value(id).first();
+    }
+    return id;
+}
+
+// Signal bars (0..4) for a signal strength in percent. Starting from the bars
+// shown so far, they only change once the strength is clearly past a
+// threshold, so a signal wobbling around one does not make the entry flicker
+static int signalBars(int strength, int currentBars)
+{
+    const int hysteresis = 5;
+
+    if (currentBars < 0) {
+        return qBound(0, strength / 20, 4);
+    }
+    if (((strength - hysteresis) / 20) > currentBars) {
+        return qBound(0, (strength - hysteresis) / 20, 4);
+    }
+    if (((strength + hysteresis) / 20) < currentBars) {
+        return qBound(0, (strength + hysteresis) / 20, 4);
+    }
+    return currentBars;
+}
+
+// Menu text of a WiFi list entry, e.g. "###.*MyNetwork"
+static QString apListEntryText(const QString &ssid, bool secured, int bars)
+{
+    return QString("%1%2%3%4")
+        .arg(QString("#").repeated(bars))
+        .arg(QString(".").repeated(4 - bars))
+        .arg(secured ? "*" : " ")
+        .arg(ssid);
+}
+
 // Constructor and initialization routines (Opening files, connecting to LCDd, ...)
-LcdClient::LcdClient(QObject *parent)
-    : QObject(parent)
+LcdClient::LcdClient(quint16 lcdPort, QObject *parent)
+    : QObject(parent), nextPageNumber(0)
 {
     connect(&mainMenuRefreshTimer, &QTimer::timeout, this, &LcdClient::updateMainMenuEntries);
 
+    // Signal strength changes are collected and applied at most once a second
+    apListRefreshTimer.setSingleShot(true);
+    apListRefreshTimer.setInterval(1000);
+    connect(&apListRefreshTimer, &QTimer::timeout, this, &LcdClient::refreshApLists);
+
     connect(&lcdSocket, &QIODevice::readyRead, this, &LcdClient::readServerResponse);
     connect(&lcdSocket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this, &LcdClient::handleSocketError);
     lcdSocket.abort();
-    lcdSocket.connectToHost("127.0.0.1", 13666);
+    lcdSocket.connectToHost("127.0.0.1", lcdPort);
 
     lcdSocket.write("hello\n");
 }
@@ -38,6 +86,10 @@ void LcdClient::readServerResponse()
         } else if (line == "menuevent enter _client_menu_") {
             updateMainMenuEntries();
 
+        } else if (line.startsWith("menuevent enter _grp_")) {
+            // A device type group (or a page of one) has been selected in the main menu
+            populateGroup(line.split(" ")[2]);
+
         } else if (line.startsWith("menuevent enter ") && (line.count("_") == 0)) {
             // An interface has been selected in the menu
             qDebug() << "updateSubMenuEntries(" << line.split(" ")[2] << ");";
@@ -48,12 +100,27 @@ void LcdClient::readServerResponse()
             qDebug() << "ScanAndConnect(" << line.split(" ")[2].split("_")[0] << ");";
             scanAndConnect(line.split(" ")[2].split("_")[0]);
 
+        } else if (
+            line.startsWith("menuevent enter ") &&
+            (line.split(" ")[2].split("_").size() == 3) &&
+            (line.split(" ")[2].split("_")[1] == "list")
+        ) {
+            // A WiFi list entry ("wlan0_list_3") has been entered. Remember its
+            // SSID and stop re-sorting the list until the user is back in the
+            // interface menu or has connected. LCDd also sends "leave" for the
+            // entry when one of its editors is opened, so that is no hint.
+            // Slots do not move while frozen, so the entry entered last counts
+            QString interfaceName = line.split(" ")[2].split("_")[0];
+            int slot = line.split(" ")[2].split("_")[2].toInt();
+            frozenApLists.insert(interfaceName);
+            apListSelections[interfaceName] = apLists.value(interfaceName).value(slot).ssid;
+
         } else if (
             line.startsWith("menuevent update ") ||
             line.startsWith("menuevent select ")
         ) {
             // "Update" means some property has been changed in a menu
-            // Examples: "eth0_dhcp off", "eth0_ip 192.168.1.1", "eth0_prefix 24", wlan0_list_1234_pass ABCDEDFG"
+            // Examples: "eth0_dhcp off", "eth0_ip 192.168.1.1", "eth0_prefix 24", wlan0_list_3_pass ABCDEDFG"
             //
             // "Select" means that an action shall be executed
             // Examples: "wlan0_disconnect"
@@ -62,7 +129,17 @@ void LcdClient::readServerResponse()
             QString optionName = parts[3];
             QString newValue = "";
 
-            if ((parts.size() == 7) && (optionName == "list")) {
+            if (optionName == "startAP") {
+                // Examples: "wlan0_startAP_ssid MyHotspot", "wlan0_startAP_band 1", "wlan0_startAP_start"
+                if (parts.size() == 6) {
+                    hotspotOptions[parts[4]] = parts[5];
+                    qDebug() << "hotspotOptions" << hotspotOptions;
+                } else if ((parts.size() == 5) && (parts[4] == "start")) {
+                    startHotspot(interfaceName);
+                }
+                return;
+
+            } else if ((parts.size() == 7) && (optionName == "list")) {
                 wiFiConnectOptions[parts[5]] = parts[6];
                 qDebug() << "wiFiConnectOptions" << wiFiConnectOptions;
                 if ((parts[5] == "dhcp") && (parts[6] == "on")) {
@@ -191,74 +268,270 @@ void LcdClient::updateNetworkConfig(QString interfaceName, QString optionName, Q
 
 void LcdClient::scanAndConnect(QString interfaceName)
 {
-    Device::Ptr dev;
-    WirelessDevice::Ptr wDev;
-    QDBusPendingReply<> reply;
-
-    dev = findInterfaceByName(interfaceName);
-    wDev = dev.dynamicCast<WirelessDevice>();
-
     emptyMenu(QString("%1_list").arg(interfaceName));
 
+    // Forget the entries of the previous scan on this interface
+    clearApList(interfaceName);
+
     // Clear the list of options entered for the WiFi to connect to and set defaults
     wiFiConnectOptions.clear();
     wiFiConnectOptions["dhcp"] = "on";
     wiFiConnectOptions["ip"] = "192.168.123.234";
     wiFiConnectOptions["prefix"] = "24";
 
+    AccessPointInfo ap;
+    QHash<QString, int> slotBySsid;
+    QList<ApListEntry> &entries = apLists[interfaceName];
+    foreach(ap, scanAccessPoints(interfaceName)) {
+        // We are removing duplicates here, the entry shows the strongest AP
+        if (!slotBySsid.contains(ap.ssid)) {
+            ApListEntry entry;
+            entry.ssid = ap.ssid;
+            entry.secured = ap.secured;
+            entry.bars = -1;
+            slotBySsid[ap.ssid] = entries.size();
+            entries.append(entry);
+        }
+        entries[slotBySsid[ap.ssid]].apStrengths[ap.path] = ap.signalStrength;
+    }
+
+    sortApList(interfaceName);
+
+    // Menu ids are slots in the sorted list, not APs. Re-sorting later on
+    // then only changes the texts of the slots, see refreshApList()
+    for (int slot = 0; slot < entries.size(); slot++) {
+        QString text = apListEntryText(entries[slot].ssid, entries[slot].secured, entries[slot].bars);
+        apListTexts[interfaceName].append(text);
+
+        // The list entry itself as a menu
+        addMenuItem(
+            QString("%1_list").arg(interfaceName),
+            QString("%1_list_%2").arg(interfaceName).arg(slot),
+            QString("menu \"%1\"").arg(text));
+
+        // The network's passphrase/key
+        addMenuItem(
+            QString("%1_list_%2").arg(interfaceName).arg(slot),
+            QString("%1_list_%2_pass").arg(interfaceName).arg(slot),
+            "alpha \"Password\" -value \"\" -minlength 8 -maxlength 32 -allow_caps true -allow_noncaps true -allow_numbers true -allowed_extra \"!§$%&/()=@\"");
+
+        // IPv4 settings
+        addMenuItem(
+            QString("%1_list_%2").arg(interfaceName).arg(slot),
+            QString("%1_list_%2_dhcp").arg(interfaceName).arg(slot),
+            "checkbox \"DHCP\" -value on");
+        addMenuItem(
+            QString("%1_list_%2").arg(interfaceName).arg(slot),
+            QString("%1_list_%2_ip").arg(interfaceName).arg(slot),
+            "ip \"IP\" -is_hidden true -value \"192.168.123.234\"");
+        addMenuItem(
+            QString("%1_list_%2").arg(interfaceName).arg(slot),
+            QString("%1_list_%2_prefix").arg(interfaceName).arg(slot),
+            "numeric \"PrefixLn\" -is_hidden true -minvalue \"1\" -maxvalue \"31\" -value \"24\"");
+
+        // The "CONNECT" button
+        addMenuItem(
+            QString("%1_list_%2").arg(interfaceName).arg(slot),
+            QString("%1_list_%2_connect").arg(interfaceName).arg(slot),
+            "action \"CONNECT\"");
+    }
+    delMenuItem(QString("%1_list").arg(interfaceName), QString("%1_list_dummy").arg(interfaceName));
+
+}
+
+// Drop the WiFi list of an interface and stop following its APs
+void LcdClient::clearApList(QString interfaceName)
+{
+    QMetaObject::Connection apConnection;
+    foreach(apConnection, apListConnections.value(interfaceName)) {
+        disconnect(apConnection);
+    }
+    apListConnections.remove(interfaceName);
+    apLists.remove(interfaceName);
+    apListTexts.remove(interfaceName);
+    dirtyApLists.remove(interfaceName);
+    frozenApLists.remove(interfaceName);
+    apListSelections.remove(interfaceName);
+}
+
+// The user has left the WiFi list, it may be re-sorted again
+void LcdClient::unfreezeApList(QString interfaceName)
+{
+    if (!frozenApLists.contains(interfaceName)) {
+        return;
+    }
+    frozenApLists.remove(interfaceName);
+    apListSelections.remove(interfaceName);
+    dirtyApLists.insert(interfaceName);
+    if (!apListRefreshTimer.isActive()) {
+        apListRefreshTimer.start();
+    }
+}
+
+// Update the signal bars of all entries and, unless the user is inside
+// one of them, sort by bars (strongest first) and SSID
+void LcdClient::sortApList(QString interfaceName)
+{
+    QList<ApListEntry> &entries = apLists[interfaceName];
+
+    for (int slot = 0; slot < entries.size(); slot++) {
+        int strength = 0;
+        int apStrength;
+        foreach(apStrength, entries[slot].apStrengths) {
+            strength = qMax(strength, apStrength);
+        }
+        entries[slot].bars = signalBars(strength, entries[slot].bars);
+    }
+
+    if (frozenApLists.contains(interfaceName)) {
+        return;
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const ApListEntry &a, const ApListEntry &b) {
+        if (a.bars != b.bars) {
+            return a.bars > b.bars;
+        }
+        return a.ssid < b.ssid;
+    });
+}
+
+// Remember a new signal strength, the list is refreshed by apListRefreshTimer
+void LcdClient::apSignalStrengthChanged(QString interfaceName, QString apPath, int strength)
+{
+    QHash<QString, QList<ApListEntry>>::iterator apList = apLists.find(interfaceName);
+    if (apList == apLists.end()) {
+        return;
+    }
+    QList<ApListEntry> &entries = apList.value();
+
+    for (int slot = 0; slot < entries.size(); slot++) {
+        if (entries[slot].apStrengths.contains(apPath)) {
+            entries[slot].apStrengths[apPath] = strength;
+            dirtyApLists.insert(interfaceName);
+            if (!apListRefreshTimer.isActive()) {
+                apListRefreshTimer.start();
+            }
+            return;
+        }
+    }
+}
+
+// An AP is gone, its entry falls back to the remaining APs with that SSID (or 0 bars)
+void LcdClient::apDisappeared(QString interfaceName, QString apPath)
+{
+    QHash<QString, QList<ApListEntry>>::iterator apList = apLists.find(interfaceName);
+    if (apList == apLists.end()) {
+        return;
+    }
+    QList<ApListEntry> &entries = apList.value();
+
+    for (int slot = 0; slot < entries.size(); slot++) {
+        if (entries[slot].apStrengths.remove(apPath)) {
+            dirtyApLists.insert(interfaceName);
+            if (!apListRefreshTimer.isActive()) {
+                apListRefreshTimer.start();
+            }
+            return;
+        }
+    }
+}
+
+// Re-sort a WiFi list and send the texts of the slots that changed.
+// Entries are never deleted and re-added for that
+void LcdClient::refreshApList(QString interfaceName)
+{
+    if (!apLists.contains(interfaceName)) {
+        return;
+    }
+    sortApList(interfaceName);
+
+    const QList<ApListEntry> &entries = apLists[interfaceName];
+    QStringList &texts = apListTexts[interfaceName];
+
+    for (int slot = 0; (slot < entries.size()) && (slot < texts.size()); slot++) {
+        QString text = apListEntryText(entries[slot].ssid, entries[slot].secured, entries[slot].bars);
+        if (texts[slot] == text) {
+            continue;
+        }
+        texts[slot] = text;
+        lcdSocket.write(QString("menu_set_item \"\" \"%1_list_%2\" -text \"%3\"\n")
+            .arg(interfaceName)
+            .arg(slot)
+            .arg(text)
+            .toLatin1());
+    }
+}
+
+void LcdClient::refreshApLists()
+{
+    QString interfaceName;
+    foreach(interfaceName, dirtyApLists) {
+        refreshApList(interfaceName);
+    }
+    dirtyApLists.clear();
+}
+
+// All network devices known to NetworkManager
+QList<LcdClient::InterfaceInfo> LcdClient::networkDevices()
+{
+    QList<InterfaceInfo> interfaces;
+    const Device::List deviceList = NetworkManager::networkInterfaces();
+
+    for (Device::Ptr dev : deviceList) {
+        InterfaceInfo info;
+        info.name = dev->interfaceName();
+        info.type = dev->type();
+        info.state = dev->state();
+        interfaces.append(info);
+    }
+
+    return interfaces;
+}
+
+// Scan for WiFi networks on an interface and return the visible APs.
+// Their signal strength (and disappearance) is followed until the next
+// scan, see apSignalStrengthChanged() and apDisappeared()
+QList<LcdClient::AccessPointInfo> LcdClient::scanAccessPoints(QString interfaceName)
+{
+    Device::Ptr dev;
+    WirelessDevice::Ptr wDev;
+    QDBusPendingReply<> reply;
+    QList<AccessPointInfo> accessPoints;
+
+    dev = findInterfaceByName(interfaceName);
+    wDev = dev.dynamicCast<WirelessDevice>();
+
     reply = wDev->requestScan();
     reply.waitForFinished();
     usleep(10000000);
 
     qDebug() << "WIFI LIST ENTRY:" << wDev->accessPoints();
     QString apPath;
-    AccessPoint *ap;
-    QStringList ssids;
+    AccessPoint::Ptr ap;
     foreach(apPath, wDev->accessPoints()) {
-        ap = new AccessPoint(apPath);
-        qDebug() << "PATH:" << apPath.split("/")[5] << "SSID:" << ap->ssid();
-        // We are removing duplicates here
-        if (!ssids.contains(ap->ssid())) {
-            ssids.append(ap->ssid());
-
-            ssidMap[apPath.split("/")[5]] = ap->ssid();
-
-            // The list entry itself as a menu
-            addMenuItem(
-                QString("%1_list").arg(interfaceName),
-                QString("%1_list_%2").arg(interfaceName).arg(apPath.split("/")[5]),
-                QString("menu \"%1\"").arg(ap->ssid()));
-
-            // The network's passphrase/key
-            addMenuItem(
-                QString("%1_list_%2").arg(interfaceName).arg(apPath.split("/")[5]),
-                QString("%1_list_%2_pass").arg(interfaceName).arg(apPath.split("/")[5]),
-                "alpha \"Password\" -value \"\" -minlength 8 -maxlength 32 -allow_caps true -allow_noncaps true -allow_numbers true -allowed_extra \"!§$%&/()=@\"");
-
-            // IPv4 settings
-            addMenuItem(
-                QString("%1_list_%2").arg(interfaceName).arg(apPath.split("/")[5]),
-                QString("%1_list_%2_dhcp").arg(interfaceName).arg(apPath.split("/")[5]),
-                "checkbox \"DHCP\" -value on");
-            addMenuItem(
-                QString("%1_list_%2").arg(interfaceName).arg(apPath.split("/")[5]),
-                QString("%1_list_%2_ip").arg(interfaceName).arg(apPath.split("/")[5]),
-                "ip \"IP\" -is_hidden true -value \"192.168.123.234\"");
-            addMenuItem(
-                QString("%1_list_%2").arg(interfaceName).arg(apPath.split("/")[5]),
-                QString("%1_list_%2_prefix").arg(interfaceName).arg(apPath.split("/")[5]),
-                "numeric \"PrefixLn\" -is_hidden true -minvalue \"1\" -maxvalue \"31\" -value \"24\"");
-
-            // The "CONNECT" button
-            addMenuItem(
-                QString("%1_list_%2").arg(interfaceName).arg(apPath.split("/")[5]),
-                QString("%1_list_%2_connect").arg(interfaceName).arg(apPath.split("/")[5]),
-                "action \"CONNECT\"");
-        }
-        delete ap;
+        ap = wDev->findAccessPoint(apPath);
+        if (ap.isNull()) {
+            continue;
+        }
+        qDebug() << "PATH:" << apPath.split("/")[5] << "SSID:" << ap->ssid() << "Signal:" << ap->signalStrength();
+
+        AccessPointInfo info;
+        info.path = apPath;
+        info.ssid = ap->ssid();
+        info.secured = (ap->capabilities() & AccessPoint::Privacy) || ap->wpaFlags() || ap->rsnFlags();
+        info.signalStrength = ap->signalStrength();
+        accessPoints.append(info);
+
+        apListConnections[interfaceName].append(
+            connect(ap.data(), &AccessPoint::signalStrengthChanged, this, [this, interfaceName, apPath](int strength) {
+                apSignalStrengthChanged(interfaceName, apPath, strength);
+            }));
     }
-    delMenuItem(QString("%1_list").arg(interfaceName), QString("%1_list_dummy").arg(interfaceName));
+    apListConnections[interfaceName].append(
+        connect(wDev.data(), &WirelessDevice::accessPointDisappeared, this, [this, interfaceName](const QString &apPath) {
+            apDisappeared(interfaceName, apPath);
+        }));
 
+    return accessPoints;
 }
 
 Device::Ptr LcdClient::findInterfaceByName(QString interfaceName)
@@ -296,7 +569,7 @@ Connection::Ptr LcdClient::getOrCreateEthernetConection(QString interfaceName)
     // If not, we create one here
     if (!found) {
         QString uuid = QUuid::createUuid().toString().mid(1, QUuid::createUuid().toString().length() - 2);
-        ConnectionSettings *newConSettings = new ConnectionSettings(ConnectionSettings::Wired);
+        ConnectionSettings::Ptr newConSettings = ConnectionSettings::Ptr(new ConnectionSettings(ConnectionSettings::Wired));
         qDebug() << "Creating new connection for" << interfaceName << ":" << newConSettings;
         newConSettings->setId(interfaceName);
         newConSettings->setUuid(uuid);
@@ -322,9 +595,9 @@ Connection::Ptr LcdClient::getOrCreateEthernetConection(QString interfaceName)
 }
 
 // Connect to a WiFi access point
-void LcdClient::connectToWifi(QString interfaceName, QString apPath)
+void LcdClient::connectToWifi(QString interfaceName, QString slot)
 {
-    // InterfaceName and last part of the AP's path is in the parameter
+    // InterfaceName and the slot in the WiFi list are in the parameters
     // all other options are in wiFiConnectOptions
 
     Device::Ptr dev = findInterfaceByName(interfaceName);
@@ -332,8 +605,12 @@ void LcdClient::connectToWifi(QString interfaceName, QString apPath)
     // Check if a connection with that id already exists
     // otherwise, create a new one
 
-    qDebug() << "connectToWifi" << interfaceName << apPath;
-    qDebug() << "SSID:" << ssidMap[apPath];
+    // Use the SSID of the entry the user entered, the slot could show
+    // another one by now if the list was re-sorted
+    qDebug() << "connectToWifi" << interfaceName << slot;
+    QString ssid = apListSelections.value(interfaceName, apLists.value(interfaceName).value(slot.toInt()).ssid);
+    unfreezeApList(interfaceName);
+    qDebug() << "SSID:" << ssid;
 
     Connection::Ptr con;
     const Connection::List conList = NetworkManager::listConnections();
@@ -341,7 +618,7 @@ void LcdClient::connectToWifi(QString interfaceName, QString apPath)
     // There should be exactly one connection with the ssid as id
     int found = 0;
     foreach(con, conList) {
-        if (con->name() == ssidMap[apPath]) {
+        if (con->name() == ssid) {
             found = 1;
             break;
         }
@@ -354,13 +631,13 @@ void LcdClient::connectToWifi(QString interfaceName, QString apPath)
         settings = ConnectionSettings::Ptr(settingsPtr);
         qDebug() << "Creating new connection for" << interfaceName << ":" << settings;
         settings->setUuid(uuid);
-        settings->setId(ssidMap[apPath]);
+        settings->setId(ssid);
     } else {
         settings = con->settings();
     }
 
     WirelessSetting::Ptr wirelessSetting = settings->setting(Setting::Wireless).dynamicCast<WirelessSetting>();
-    wirelessSetting->setSsid(ssidMap[apPath].toUtf8());
+    wirelessSetting->setSsid(ssid.toUtf8());
     settings->setInterfaceName(interfaceName);
     settings->setAutoconnect(true);
 
@@ -416,9 +693,337 @@ void LcdClient::connectToWifi(QString interfaceName, QString apPath)
     }
 }
 
+// Find the hotspot (AP mode) profile bound to an interface, if there is one
+Connection::Ptr LcdClient::findHotspotConnection(QString interfaceName)
+{
+    Connection::Ptr con;
+    ConnectionSettings::Ptr settings;
+    WirelessSetting::Ptr wirelessSetting;
+    const Connection::List conList = NetworkManager::listConnections();
+
+    foreach(con, conList) {
+        settings = con->settings();
+        if (
+            (settings->connectionType() != ConnectionSettings::Wireless) ||
+            (settings->interfaceName() != interfaceName)
+        ) {
+            continue;
+        }
+        wirelessSetting = settings->setting(Setting::Wireless).dynamicCast<WirelessSetting>();
+        if (wirelessSetting->mode() == WirelessSetting::Ap) {
+            return con;
+        }
+    }
+
+    return Connection::Ptr();
+}
+
+// The settings stored in a hotspot profile
+ConnectionSettings::Ptr LcdClient::hotspotSettings(Connection::Ptr con)
+{
+    return con->settings();
+}
+
+// Bring up a hotspot (AP mode, shared IPv4) on a WiFi interface
+// All options are in hotspotOptions. An existing hotspot profile for the
+// interface is reused. None of the D-Bus calls are waited for, progress
+// is shown in the "<iface>_startAP_status" entry instead
+void LcdClient::startHotspot(QString interfaceName)
+{
+    WirelessDevice::Capabilities capabilities;
+    QString ssid = hotspotOptions["ssid"];
+    QString pass = hotspotOptions["pass"];
+
+    qDebug() << "startHotspot" << interfaceName << hotspotOptions;
+
+    // Validate everything before NetworkManager gets involved
+    if (hotspotTimers.contains(interfaceName)) {
+        return;
+    }
+    capabilities = wirelessCapabilities(interfaceName);
+    if (!capabilities) {
+        setHotspotStatus(interfaceName, "Error: No WiFi dev");
+        return;
+    }
+    if (!(capabilities & WirelessDevice::ApCap)) {
+        setHotspotStatus(interfaceName, "Error: No AP mode");
+        return;
+    }
+    if (
+        (hotspotOptions["band"] == "1") &&
+        (capabilities & WirelessDevice::FreqValid) &&
+        !(capabilities & WirelessDevice::Freq5Ghz)
+    ) {
+        setHotspotStatus(interfaceName, "Error: No 5GHz");
+        return;
+    }
+    if (ssid.isEmpty() || (ssid.toUtf8().size() > 32)) {
+        setHotspotStatus(interfaceName, "Error: Bad SSID");
+        return;
+    }
+
+    // A WPA-PSK passphrase is 8 to 63 printable ASCII characters. An empty
+    // one keeps the passphrase stored in an existing hotspot profile
+    Connection::Ptr con = findHotspotConnection(interfaceName);
+    bool passValid = (pass.size() >= 8) && (pass.size() <= 63);
+    QChar passChar;
+    foreach(passChar, pass) {
+        if ((passChar.unicode() < 0x20) || (passChar.unicode() > 0x7e)) {
+            passValid = false;
+        }
+    }
+    if ((pass.isEmpty() && con.isNull()) || (!pass.isEmpty() && !passValid)) {
+        setHotspotStatus(interfaceName, "Error: Bad password");
+        return;
+    }
+
+    ConnectionSettings::Ptr settings;
+    if (con.isNull()) {
+        QString uuid = QUuid::createUuid().toString().mid(1, QUuid::createUuid().toString().length() - 2);
+        settings = ConnectionSettings::Ptr(new ConnectionSettings(ConnectionSettings::Wireless));
+        qDebug() << "Creating new hotspot connection for" << interfaceName << ":" << settings;
+        settings->setUuid(uuid);
+        settings->setId(QString("Hotspot %1").arg(interfaceName));
+    } else {
+        settings = hotspotSettings(con);
+    }
+    settings->setInterfaceName(interfaceName);
+    settings->setAutoconnect(false);
+
+    WirelessSetting::Ptr wirelessSetting = settings->setting(Setting::Wireless).dynamicCast<WirelessSetting>();
+    wirelessSetting->setSsid(ssid.toUtf8());
+    wirelessSetting->setMode(WirelessSetting::Ap);
+    if (hotspotOptions["band"] == "1") {
+        wirelessSetting->setBand(WirelessSetting::A);
+    } else {
+        wirelessSetting->setBand(WirelessSetting::Bg);
+    }
+
+    WirelessSecuritySetting::Ptr wifiSecurity = settings->setting(Setting::WirelessSecurity).dynamicCast<WirelessSecuritySetting>();
+    wifiSecurity->setKeyMgmt(WirelessSecuritySetting::WpaPsk);
+    wifiSecurity->setProto(QList<WirelessSecuritySetting::WpaProtocolVersion>() << WirelessSecuritySetting::Rsn);
+    wifiSecurity->setPairwise(QList<WirelessSecuritySetting::WpaEncryptionCapabilities>() << WirelessSecuritySetting::Ccmp);
+    wifiSecurity->setGroup(QList<WirelessSecuritySetting::WpaEncryptionCapabilities>() << WirelessSecuritySetting::Ccmp);
+    if (!pass.isEmpty()) {
+        wifiSecurity->setPsk(pass);
+    }
+    wifiSecurity->setInitialized(true);
+    wirelessSetting->setSecurity("802-11-wireless-security");
+
+    Ipv4Setting::Ptr ipv4Setting = settings->setting(Setting::Ipv4).dynamicCast<Ipv4Setting>();
+    ipv4Setting->setAddresses(QList<IpAddress>());
+    ipv4Setting->setMethod(Ipv4Setting::Shared);
+
+    // Same as in connectToWifi(): Add the settings missing on settings->toMap()
+    NMVariantMapMap resultingSettings = settings->toMap();
+    resultingSettings.insert(wirelessSetting->name(), wirelessSetting->toMap());
+    resultingSettings.insert(wifiSecurity->name(), wifiSecurity->toMap());
+    resultingSettings.insert(ipv4Setting->name(), ipv4Setting->toMap());
+
+    qDebug() << "New hotspot settings" << resultingSettings;
+
+    hotspotTimers[interfaceName].start();
+    setHotspotStatus(interfaceName, "Saving ...");
+
+    activateHotspot(interfaceName, con, resultingSettings);
+}
+
+// Capabilities of a WiFi device, none if it is no (or no longer a) WiFi device
+WirelessDevice::Capabilities LcdClient::wirelessCapabilities(QString interfaceName)
+{
+    WirelessDevice::Ptr wDev = findInterfaceByName(interfaceName).dynamicCast<WirelessDevice>();
+
+    if (wDev.isNull() || (wDev->interfaceName() != interfaceName)) {
+        return WirelessDevice::NoCapability;
+    }
+    return wDev->wirelessCapabilities();
+}
+
+// Add (or update) and activate the hotspot profile without waiting for any
+// of the D-Bus calls. Ends in watchHotspotActivation() or hotspotFailed()
+void LcdClient::activateHotspot(QString interfaceName, Connection::Ptr con, NMVariantMapMap settings)
+{
+    QString devUni = findInterfaceByName(interfaceName)->uni();
+
+    if (con.isNull()) {
+        QDBusPendingReply<QDBusObjectPath, QDBusObjectPath> reply = NetworkManager::addAndActivateConnection(settings, devUni, "");
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, interfaceName](QDBusPendingCallWatcher *watcher) {
+            QDBusPendingReply<QDBusObjectPath, QDBusObjectPath> reply = *watcher;
+            watcher->deleteLater();
+            qDebug() << reply.isValid() << reply.error();
+            if (reply.isError()) {
+                hotspotFailed(interfaceName, "Error: Not added");
+                return;
+            }
+            watchHotspotActivation(interfaceName, reply.argumentAt<1>().path());
+        });
+    } else {
+        qDebug() << "Connection" << con->path() << "(" << con->name() << ") on device" << devUni << ": Updating and activating hotspot, ...";
+        QString conPath = con->path();
+        QDBusPendingReply<> reply = con->update(settings);
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, interfaceName, conPath, devUni](QDBusPendingCallWatcher *watcher) {
+            QDBusPendingReply<> reply = *watcher;
+            watcher->deleteLater();
+            qDebug() << reply.isValid() << reply.error();
+            if (reply.isError()) {
+                hotspotFailed(interfaceName, "Error: Not saved");
+                return;
+            }
+            setHotspotStatus(interfaceName, "Starting ...");
+
+            QDBusPendingReply<QDBusObjectPath> activateReply = activateConnection(conPath, devUni, "");
+            QDBusPendingCallWatcher *activateWatcher = new QDBusPendingCallWatcher(activateReply, this);
+            connect(activateWatcher, &QDBusPendingCallWatcher::finished, this, [this, interfaceName](QDBusPendingCallWatcher *watcher) {
+                QDBusPendingReply<QDBusObjectPath> reply = *watcher;
+                watcher->deleteLater();
+                qDebug() << reply.isValid() << reply.error();
+                if (reply.isError()) {
+                    hotspotFailed(interfaceName, "Error: Not started");
+                    return;
+                }
+                watchHotspotActivation(interfaceName, reply.value().path());
+            });
+        });
+    }
+}
+
+// A hotspot activation did not get as far as an active connection
+void LcdClient::hotspotFailed(QString interfaceName, QString status)
+{
+    hotspotTimers.remove(interfaceName);
+    setHotspotStatus(interfaceName, status);
+}
+
+// Follow the state of a hotspot's active connection until it is deactivated
+void LcdClient::watchHotspotActivation(QString interfaceName, QString activeConnectionPath)
+{
+    ActiveConnection::Ptr activeCon = NetworkManager::findActiveConnection(activeConnectionPath);
+    if (activeCon.isNull()) {
+        hotspotFailed(interfaceName, "Error: Not started");
+        return;
+    }
+
+    if (hotspotActivations.contains(interfaceName)) {
+        disconnect(hotspotActivations[interfaceName].data(), nullptr, this, nullptr);
+    }
+    hotspotActivations[interfaceName] = activeCon;
+
+    connect(activeCon.data(), &ActiveConnection::stateChanged, this, [this, interfaceName](ActiveConnection::State state) {
+        hotspotStateChanged(interfaceName, state);
+    });
+    hotspotStateChanged(interfaceName, activeCon->state());
+}
+
+// Follow a hotspot for its whole lifetime, so the status line also shows
+// when it stops or fails after having been up
+void LcdClient::hotspotStateChanged(QString interfaceName, ActiveConnection::State state)
+{
+    if (state == ActiveConnection::Activating) {
+        setHotspotStatus(interfaceName, "Starting ...");
+
+    } else if ((state == ActiveConnection::Activated) && hotspotTimers.contains(interfaceName)) {
+        // This is the time until NetworkManager reports the AP connection as
+        // activated. The first beacon goes out at about that time, but it is
+        // not observed here
+        qint64 timeToActivated = hotspotTimers.take(interfaceName).elapsed();
+        qDebug() << "Hotspot on" << interfaceName << "activated after" << timeToActivated << "ms";
+        setHotspotStatus(interfaceName, QString("Up (%1ms)").arg(timeToActivated));
+
+    } else if ((state == ActiveConnection::Deactivating) || (state == ActiveConnection::Deactivated)) {
+        if (hotspotTimers.contains(interfaceName)) {
+            hotspotTimers.remove(interfaceName);
+            setHotspotStatus(interfaceName, "Error: Failed");
+        } else {
+            setHotspotStatus(interfaceName, "Status: Stopped");
+        }
+        if (hotspotActivations.contains(interfaceName)) {
+            disconnect(hotspotActivations.take(interfaceName).data(), nullptr, this, nullptr);
+        }
+    }
+}
+
+// Show the hotspot progress in the "Start NEW AP" menu
+void LcdClient::setHotspotStatus(QString interfaceName, QString status)
+{
+    hotspotStatus[interfaceName] = status;
+    lcdSocket.write(QString("menu_set_item \"\" \"%1_startAP_status\" -text \"%2\"\n")
+        .arg(interfaceName)
+        .arg(status)
+        .toLatin1());
+}
+
 // Update the menu items for one interface
 // Entries strongly depend on device type and connection status
 void LcdClient::updateSubMenuEntries(QString interfaceName)
+{
+    // Back in the interface menu means the user has left the WiFi list
+    unfreezeApList(interfaceName);
+
+    // Add a dummy entry so one is not kicked out of the menu when emptying it
+    addMenuItem(interfaceName, QString("%1_dummy").arg(interfaceName), "action \"ERROR\"");
+    emptyMenu(interfaceName);
+
+    // Step 1 to 3: The entries of the interface's connection
+    Device::Type type = addConnectionEntries(interfaceName);
+    if (type == Device::UnknownType) {
+        return;
+    }
+
+    // Step 4: Special entries only for WiFi interfaces
+    if (type == Device::Wifi) {
+        addMenuItem(interfaceName, QString("%1_list").arg(interfaceName),
+            QString("menu \"ScanAndConnect\""));
+
+        addMenuItem(QString("%1_list").arg(interfaceName), QString("%1_list_dummy").arg(interfaceName),
+            QString("action \"Scanning ...\""));
+
+        // Hotspot defaults, taken from an existing hotspot profile if there is one
+        hotspotOptions.clear();
+        hotspotOptions["ssid"] = "Hotspot";
+        hotspotOptions["pass"] = "";
+        hotspotOptions["band"] = "0";
+
+        Connection::Ptr hotspotCon = findHotspotConnection(interfaceName);
+        if (!hotspotCon.isNull()) {
+            WirelessSetting::Ptr hotspotSetting = hotspotSettings(hotspotCon)->setting(Setting::Wireless).dynamicCast<WirelessSetting>();
+            hotspotOptions["ssid"] = QString::fromUtf8(hotspotSetting->ssid());
+            if (hotspotSetting->band() == WirelessSetting::A) {
+                hotspotOptions["band"] = "1";
+            }
+        }
+
+        addMenuItem(interfaceName, QString("%1_startAP").arg(interfaceName),
+            QString("menu \"Start NEW AP\""));
+
+        addMenuItem(QString("%1_startAP").arg(interfaceName), QString("%1_startAP_ssid").arg(interfaceName),
+            QString("alpha \"SSID\" -value \"%1\" -minlength 1 -maxlength 32 -allow_caps true -allow_noncaps true -allow_numbers true -allowed_extra \"-\"")
+            .arg(hotspotOptions["ssid"]));
+
+        // An empty password keeps the one stored in an existing hotspot profile
+        addMenuItem(QString("%1_startAP").arg(interfaceName), QString("%1_startAP_pass").arg(interfaceName),
+            "alpha \"Password\" -value \"\" -minlength 8 -maxlength 63 -allow_caps true -allow_noncaps true -allow_numbers true -allowed_extra \"!$%&/()=@\"");
+
+        addMenuItem(QString("%1_startAP").arg(interfaceName), QString("%1_startAP_band").arg(interfaceName),
+            QString("ring \"Band\" -strings \"2.4GHz\t5GHz\" -value %1")
+            .arg(hotspotOptions["band"]));
+
+        addMenuItem(QString("%1_startAP").arg(interfaceName), QString("%1_startAP_start").arg(interfaceName),
+            "action \"START\"");
+
+        addMenuItem(QString("%1_startAP").arg(interfaceName), QString("%1_startAP_status").arg(interfaceName),
+            QString("action \"%1\"")
+            .arg(hotspotStatus.value(interfaceName, "Status: Idle")));
+    }
+
+    delMenuItem(interfaceName, QString("%1_dummy").arg(interfaceName));
+}
+
+// Add the entries of an interface's connection (the active one for WiFi)
+// to its menu. Returns the device type, UnknownType if there is no connection
+// for an Ethernet device
+Device::Type LcdClient::addConnectionEntries(QString interfaceName)
 {
     Device::Ptr dev;
     WirelessDevice::Ptr wDev;
@@ -430,10 +1035,6 @@ void LcdClient::updateSubMenuEntries(QString interfaceName)
     // Initialize as NULL
     settings = QSharedPointer<ConnectionSettings>();
 
-    // Add a dummy entry so one is not kicked out of the menu when emptying it
-    addMenuItem(interfaceName, QString("%1_dummy").arg(interfaceName), "action \"ERROR\"");
-    emptyMenu(interfaceName);
-
     // Step 1: Get the proper device entry
     dev = findInterfaceByName(interfaceName);
 
@@ -445,7 +1046,7 @@ void LcdClient::updateSubMenuEntries(QString interfaceName)
 
         if (con.isNull()) {
             qDebug() << "CONNECTION STILL NOT FOUND";
-            return;
+            return Device::UnknownType;
         }
         settings = con->settings();
 
@@ -513,84 +1114,304 @@ void LcdClient::updateSubMenuEntries(QString interfaceName)
         }
     }
 
-    // Step 4: Special entries only for WiFi interfaces
-    if (dev->type() == Device::Wifi) {
-        addMenuItem(interfaceName, QString("%1_list").arg(interfaceName),
-            QString("menu \"ScanAndConnect\""));
-
-        addMenuItem(QString("%1_list").arg(interfaceName), QString("%1_list_dummy").arg(interfaceName),
-            QString("action \"Scanning ...\""));
-
-        addMenuItem(interfaceName, QString("%1_startAP").arg(interfaceName),
-            QString("menu \"Start NEW AP\""));
-
-        addMenuItem(QString("%1_startAP").arg(interfaceName), QString("%1_startAP_dummy").arg(interfaceName),
-            QString("action \"StartAP\""));
-    }
-
-    delMenuItem(interfaceName, QString("%1_dummy").arg(interfaceName));
+    return dev->type();
 }
 
-// Remove and re-add the main menu entries (= Network interfaces)
+// Update the main menu entries (= Network interfaces). Up to mainMenuPageSize
+// of them are shown directly, more are grouped by device type and split into
+// pages, see layoutGroup(). Groups are only filled in LCDd once they have
+// been entered, and afterwards only entries that were added, removed or
+// renamed are sent
 void LcdClient::updateMainMenuEntries()
 {
-    QStringList currentInterfaces;
+    QHash<QString, QString> currentTexts;       // Interface -> "name(state)"
+    QMap<QString, QStringList> typeGroups;      // Device type group id -> interfaces
+    QHash<QString, QStringList> members;        // Group id ("" = main menu) -> entries
+    QHash<QString, QString> texts;              // Group id -> text
     QString interfaceName;
-    const Device::List deviceList = NetworkManager::networkInterfaces();
-    const Connection::List conList = NetworkManager::listConnections();
-
-    // Add a dummy entry to the menu in order to not
-    // have an empty client menu that would kick the user out of it
-    addMenuItem("", "_dummy", "action \"No interfaces :(\"");
+    QString groupId;
+    QString entry;
+    InterfaceInfo dev;
 
     // To have the string representation of Device::State
     QMetaEnum metaEnum = QMetaEnum::fromType<Device::State>();
 
-    currentInterfaces.clear();
-
     // Filter the ones that are of interest here
-    // and add them to our client's menu
-    for (Device::Ptr dev : deviceList) {
+    foreach(dev, networkDevices()) {
         if (
-            ((dev->type() != Device::Wifi) && (dev->type() != Device::Ethernet)) ||
-            (dev->state() == Device::Unmanaged)
+            ((dev.type != Device::Wifi) && (dev.type != Device::Ethernet)) ||
+            (dev.state == Device::Unmanaged)
         ) {
             continue;
         }
 
-        interfaceName = dev->interfaceName();
+        interfaceName = dev.name;
+        groupId = (dev.type == Device::Wifi) ? "_grp_wifi" : "_grp_ethernet";
 
-        // If the entry is already in the menu, simply update it
-        if (menuEntries["_"].contains(interfaceName)) {
-            currentInterfaces.append(interfaceName);
-            lcdSocket.write(QString("menu_set_item \"\" \"%1\" -text \"%1(%2)\"\n")
-                .arg(interfaceName)
-                .arg(metaEnum.valueToKey(dev->state()))
-                .toLatin1());
-        } else {
-            currentInterfaces.append(interfaceName);
-            addMenuItem("", interfaceName, QString("menu \"%1(%2)\"\n")
-                .arg(interfaceName)
-                .arg(metaEnum.valueToKey(dev->state()))
-                .toLatin1());
+        typeGroups[groupId].append(interfaceName);
+        currentTexts[interfaceName] = QString("%1(%2)")
+            .arg(interfaceName)
+            .arg(metaEnum.valueToKey(dev.state));
+    }
+
+    // Lay out the menu tree as it should be now. A typical box with a few
+    // interfaces gets them right in the main menu, without groups
+    members[""] = QStringList();
+    foreach(groupId, typeGroups.keys()) {
+        QStringList interfaces = typeGroups[groupId];
+        std::sort(interfaces.begin(), interfaces.end());
+
+        if (currentTexts.size() <= mainMenuPageSize) {
+            members[""].append(interfaces);
+            continue;
         }
+        members[""].append(groupId);
+        texts[groupId] = QString("%1 (%2)")
+            .arg((groupId == "_grp_wifi") ? "WiFi" : "Ethernet")
+            .arg(interfaces.size());
+        layoutGroup(groupId, interfaces, members, texts);
     }
 
-    // Remove all interfaces from the menu, that are not in currentInterfaces
-    // (if an interface dissappeared since the last call to this function)
-    QString entry;
-    foreach(entry, menuEntries["_"]) {
-        if ((entry != "_dummy") && (!currentInterfaces.contains(entry))) {
-            delMenuItem("", entry);
+    // Add a dummy entry to the menu in order to not
+    // have an empty client menu that would kick the user out of it
+    if (members[""].isEmpty() && !menuEntries.value("_").contains("_dummy")) {
+        addMenuItem("", "_dummy", "action \"No interfaces :(\"");
+    }
+
+    // Forget everything about interfaces that dissappeared
+    // since the last call to this function
+    foreach(entry, interfaceTexts.keys()) {
+        if (!currentTexts.contains(entry)) {
+            clearApList(entry);
+            if (hotspotActivations.contains(entry)) {
+                disconnect(hotspotActivations.take(entry).data(), nullptr, this, nullptr);
+            }
+            hotspotTimers.remove(entry);
+            hotspotStatus.remove(entry);
         }
     }
 
+    // Only the main menu and the groups that have been entered exist in LCDd
+
+    // Step 1: Remove all entries that are gone or moved to another group.
+    // This has to be done first, as an id can only be in one menu at a time
+    QStringList shownGroups = populatedGroups.values();
+    shownGroups.append("");
+    foreach(groupId, shownGroups) {
+        foreach(entry, menuEntries.value(groupId.isEmpty() ? "_" : groupId)) {
+            if (!entry.endsWith("_dummy") && !members.value(groupId).contains(entry)) {
+                delGroupEntry(groupId, entry);
+            }
+        }
+        if (!groupId.isEmpty() && !members.contains(groupId)) {
+            populatedGroups.remove(groupId);
+        }
+    }
+
+    // Step 2: Add the missing entries and update the ones whose text changed,
+    // parents before their pages. LCDd can only append to a menu, so the
+    // entries after a new one are removed and added again to keep it sorted
+    shownGroups = QStringList("");
+    while (!shownGroups.isEmpty()) {
+        groupId = shownGroups.takeFirst();
+        bool appending = false;
+
+        foreach(entry, members.value(groupId)) {
+            QString text = entry.startsWith("_grp_") ? texts[entry] : currentTexts[entry];
+            QString oldText = entry.startsWith("_grp_") ? groupTexts.value(entry) : interfaceTexts.value(entry);
+            bool shown = menuEntries.value(groupId.isEmpty() ? "_" : groupId).contains(entry);
+
+            if (shown && appending) {
+                delGroupEntry(groupId, entry);
+                shown = false;
+            }
+            if (!shown) {
+                appending = true;
+                addGroupEntry(groupId, entry, text);
+            } else if (text != oldText) {
+                lcdSocket.write(QString("menu_set_item \"\" \"%1\" -text \"%2\"\n")
+                    .arg(entry)
+                    .arg(text)
+                    .toLatin1());
+            }
+
+            if (populatedGroups.contains(entry)) {
+                shownGroups.append(entry);
+            }
+        }
+    }
+
+    groupMembers = members;
+    groupTexts = texts;
+    interfaceTexts = currentTexts;
+
     // Remove the DUMMY entry again IF there are any interfaces. Otherwise,
     // leave it there as a hint to the user
-    if (menuEntries["_"].size()) {
+    if (!members[""].isEmpty() && menuEntries.value("_").contains("_dummy")) {
         delMenuItem("", "_dummy");
     }
+}
+
+// Split the (sorted) interfaces of a group into pages, so no menu has more
+// than mainMenuPageSize entries. The pages of the last layout are kept, so
+// an interface coming or going only touches the page covering its name.
+// The group is only laid out anew if it ends up with too many pages
+void LcdClient::layoutGroup(QString groupId, QStringList interfaces, QHash<QString, QStringList> &members, QHash<QString, QString> &texts)
+{
+    QHash<QString, QStringList> pageMembers;
+    QHash<QString, QString> pageTexts;
+    QStringList pages;
+
+    if (interfaces.size() <= mainMenuPageSize) {
+        members[groupId] = interfaces;
+        return;
+    }
+
+    if (groupMembers.value(groupId).value(0).startsWith("_grp_")) {
+        pages = layoutPages(groupId, groupMembers[groupId], interfaces, pageMembers, pageTexts);
+    }
+    if ((pages.size() < 2) || (pages.size() > mainMenuPageSize)) {
+        pageMembers.clear();
+        pageTexts.clear();
+        pages = addPages(groupId, interfaces, pageMembers, pageTexts);
+    }
+
+    members[groupId] = pages;
+    QString pageId;
+    foreach(pageId, pageMembers.keys()) {
+        members[pageId] = pageMembers[pageId];
+        texts[pageId] = pageTexts[pageId];
+    }
+}
+
+// Distribute the (sorted) interfaces of a group over the pages it had in the
+// last layout: Each page takes the interfaces up to the one the next page
+// started with. Returns the pages now, empty ones are dropped, too big ones
+// split and a page left with a single sub-page is replaced by it
+QStringList LcdClient::layoutPages(QString groupId, QStringList oldPages, QStringList interfaces, QHash<QString, QStringList> &members, QHash<QString, QString> &texts)
+{
+    QStringList pages;
+    int next = 0;
+
+    for (int page = 0; page < oldPages.size(); page++) {
+        QString end;
+        if ((page + 1) < oldPages.size()) {
+            end = edgeInterface(groupMembers, oldPages[page + 1], false);
+        }
+        QStringList pageInterfaces;
+        while ((next < interfaces.size()) && (end.isNull() || (interfaces[next] < end))) {
+            pageInterfaces.append(interfaces[next++]);
+        }
+        if (pageInterfaces.isEmpty()) {
+            continue;
+        }
+
+        QStringList entries = pageInterfaces;
+        if (groupMembers.value(oldPages[page]).value(0).startsWith("_grp_")) {
+            entries = layoutPages(groupId, groupMembers[oldPages[page]], pageInterfaces, members, texts);
+            if (entries.size() == 1) {
+                pages.append(entries);
+                continue;
+            }
+        }
+        pages.append(fillPages(groupId, oldPages[page], entries, members, texts));
+    }
+
+    return pages;
+}
+
+// Put the entries (interfaces or pages) on a page, or split them evenly
+// over as few pages as needed. The first one keeps the page's id
+QStringList LcdClient::fillPages(QString groupId, QString pageId, QStringList entries, QHash<QString, QStringList> &members, QHash<QString, QString> &texts)
+{
+    QStringList pages;
+    int pageCount = (entries.size() + mainMenuPageSize - 1) / mainMenuPageSize;
+
+    for (int page = 0; page < pageCount; page++) {
+        int start = page * entries.size() / pageCount;
+        int end = (page + 1) * entries.size() / pageCount;
+        if (page > 0) {
+            pageId = QString("%1_p%2").arg(groupId).arg(nextPageNumber++);
+        }
+        members[pageId] = entries.mid(start, end - start);
+        texts[pageId] = QString("%1..%2")
+            .arg(edgeInterface(members, pageId, false))
+            .arg(edgeInterface(members, pageId, true));
+        pages.append(pageId);
+    }
 
+    return pages;
+}
+
+// Lay out (sorted) interfaces on new pages: Up to mainMenuPageSize pages
+// with the same number of interfaces each, split further where needed.
+// E.g. 100 interfaces become 8 pages of 2 pages of 6 or 7 interfaces,
+// 1000 interfaces 8 pages of 8 pages of 2 pages of 7 or 8 interfaces
+QStringList LcdClient::addPages(QString groupId, QStringList interfaces, QHash<QString, QStringList> &members, QHash<QString, QString> &texts)
+{
+    QStringList pages;
+
+    if (interfaces.size() <= mainMenuPageSize) {
+        return interfaces;
+    }
+
+    int pageCount = qMin(mainMenuPageSize, (interfaces.size() + mainMenuPageSize - 1) / mainMenuPageSize);
+    for (int page = 0; page < pageCount; page++) {
+        int start = page * interfaces.size() / pageCount;
+        int end = (page + 1) * interfaces.size() / pageCount;
+        QString pageId = QString("%1_p%2").arg(groupId).arg(nextPageNumber++);
+
+        members[pageId] = addPages(groupId, interfaces.mid(start, end - start), members, texts);
+        texts[pageId] = QString("%1..%2")
+            .arg(edgeInterface(members, pageId, false))
+            .arg(edgeInterface(members, pageId, true));
+        pages.append(pageId);
+    }
+
+    return pages;
+}
+
+// Add an entry (a page or an interface) to a group menu. Pages only
+// get a placeholder, they are filled by populateGroup() once entered
+void LcdClient::addGroupEntry(QString groupId, QString id, QString text)
+{
+    addMenuItem(groupId, id, QString("menu \"%1\"").arg(text));
+
+    if (id.startsWith("_grp_")) {
+        addMenuItem(id, QString("%1_dummy").arg(id), "action \"Loading ...\"");
+    }
+}
+
+// Remove an entry from a group menu. A page and its sub-pages have to be
+// populated again once they are added again
+void LcdClient::delGroupEntry(QString groupId, QString id)
+{
+    if (id.startsWith("_grp_") && !id.endsWith("_dummy")) {
+        QString childId;
+        foreach(childId, menuEntries.value(id)) {
+            delGroupEntry(id, childId);
+        }
+        populatedGroups.remove(id);
+    }
+    delMenuItem(groupId, id);
+}
+
+// Add the entries of a group menu to LCDd when it is entered for the first time
+void LcdClient::populateGroup(QString groupId)
+{
+    if (populatedGroups.contains(groupId) || !groupMembers.contains(groupId)) {
+        return;
+    }
+    populatedGroups.insert(groupId);
+
+    // groupMembers is sorted by interface name already
+    QString entry;
+    foreach(entry, groupMembers[groupId]) {
+        addGroupEntry(groupId, entry,
+            entry.startsWith("_grp_") ? groupTexts[entry] : interfaceTexts[entry]);
+    }
+
+    delMenuItem(groupId, QString("%1_dummy").arg(groupId));
 }
 
 // Add a menu entry and store it in menuEntries so we can empty all menus easily
@@ -600,13 +1421,9 @@ void LcdClient::addMenuItem(QString parent, QString newId, QString rest)
     if (parent == "") {
         parentKey = "_";
     }
-    if (!menuEntries.contains(parentKey)) {
-        menuEntries[parentKey] = QStringList();
-    }
-
     qDebug() << "ADD. Adding" << parent << newId << rest;
 
-    menuEntries[parentKey].append(newId);
+    menuEntries[parentKey].insert(newId);
 
     lcdSocket.write(QString("menu_add_item \"%1\" \"%2\" %3\n")
         .arg(parent)
@@ -623,11 +1440,24 @@ void LcdClient::delMenuItem(QString parent, QString id)
         parentKey = "_";
     }
 
-    // TODO: Remove recursive / Children first?
+    // Children first, so neither LCDd nor menuEntries keep orphaned
+    // entries (like wlan0_list_<ap>_pass) around after the parent is gone
+    if (menuEntries.contains(id)) {
+        QString childId;
+        foreach (childId, menuEntries[id]) {
+            delMenuItem(id, childId);
+        }
+        menuEntries.remove(id);
+    }
 
     qDebug() << "DEL. Deleting" << parent << id;
 
-    menuEntries[parentKey].removeAll(id);
+    if (menuEntries.contains(parentKey)) {
+        menuEntries[parentKey].remove(id);
+        if (menuEntries[parentKey].isEmpty()) {
+            menuEntries.remove(parentKey);
+        }
+    }
     lcdSocket.write(QString("menu_del_item \"IGNORED\" \"%1\"\n")
         .arg(id)
         .toLatin1());
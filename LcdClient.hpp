@@ -6,6 +6,8 @@
 #include <QTcpSocket>
 #include <QHash>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QDBusPendingCallWatcher>
 
 #include <NetworkManagerQt/GenericTypes>
 #include <NetworkManagerQt/Manager>
@@ -30,27 +32,95 @@ class LcdClient : public QObject
     Q_OBJECT
 
 public:
-    explicit LcdClient(QObject *parent = nullptr);
+    explicit LcdClient(quint16 lcdPort = 13666, QObject *parent = nullptr);
 
 private slots:
     void readServerResponse();
     void handleSocketError(QAbstractSocket::SocketError socketError);
 
-private:
+protected:
+    // Everything below is protected (instead of private) so the tests in
+    // tests/ can replace the NetworkManager access with fakes and check the state
+
+    struct InterfaceInfo {
+        QString name;
+        Device::Type type;
+        Device::State state;
+    };
+    struct AccessPointInfo {
+        QString path;
+        QString ssid;
+        bool secured;
+        int signalStrength;
+    };
+    virtual QList<InterfaceInfo> networkDevices();
+    virtual QList<AccessPointInfo> scanAccessPoints(QString interfaceName);
+    virtual WirelessDevice::Capabilities wirelessCapabilities(QString interfaceName);
+    virtual Connection::Ptr findHotspotConnection(QString interfaceName);
+    virtual ConnectionSettings::Ptr hotspotSettings(Connection::Ptr con);
+    virtual void activateHotspot(QString interfaceName, Connection::Ptr con, NMVariantMapMap settings);
+    virtual Device::Type addConnectionEntries(QString interfaceName);
+
     QTcpSocket lcdSocket;
     QTimer mainMenuRefreshTimer;
 
-    QMap<QString, QStringList> menuEntries;
-    QMap<QString, QString> ssidMap;
+    QHash<QString, QSet<QString>> menuEntries;
+
+    // One entry of a WiFi list ("<iface>_list_<slot>"), APs with the same SSID share one
+    struct ApListEntry {
+        QString ssid;
+        bool secured;
+        int bars;                           // Hysteresis-filtered signal bars, 0..4
+        QHash<QString, int> apStrengths;    // AP path -> last reported signal strength (%)
+    };
+    QHash<QString, QList<ApListEntry>> apLists;     // Interface -> entries of the last scan, index = slot
+    QHash<QString, QStringList> apListTexts;        // Interface -> text last sent to LCDd per slot
+    QHash<QString, QList<QMetaObject::Connection>> apListConnections;
+    QSet<QString> dirtyApLists;
+    QSet<QString> frozenApLists;                    // Interfaces where the user is inside a list entry
+    QHash<QString, QString> apListSelections;       // Interface -> SSID of the entry the user is in
+    QTimer apListRefreshTimer;
     QMap<QString, QString> wiFiConnectOptions;
+    QMap<QString, QString> hotspotOptions;
+
+    // Hotspot activation state per interface
+    QHash<QString, ActiveConnection::Ptr> hotspotActivations;
+    QHash<QString, QElapsedTimer> hotspotTimers;    // Only present while an activation is in progress
+    QHash<QString, QString> hotspotStatus;
+
+    // Main menu state, so only changed entries are sent to LCDd
+    QHash<QString, QStringList> groupMembers;   // Group menu id ("" = main menu) -> sorted entries
+    QHash<QString, QString> interfaceTexts;     // Interface -> "name(state)"
+    QHash<QString, QString> groupTexts;         // Group menu id -> "type (count)" or "first..last"
+    QSet<QString> populatedGroups;              // Group menus that have been entered
+    int nextPageNumber;                         // Page ids are "<group>_p<n>", never reused
 
     Device::Ptr findInterfaceByName(QString interfaceName);
     Connection::Ptr getOrCreateEthernetConection(QString interfaceName);
-    void connectToWifi(QString interfaceName, QString apPath);
+    void connectToWifi(QString interfaceName, QString slot);
+    void startHotspot(QString interfaceName);
+    void hotspotFailed(QString interfaceName, QString status);
+    void watchHotspotActivation(QString interfaceName, QString activeConnectionPath);
+    void hotspotStateChanged(QString interfaceName, ActiveConnection::State state);
+    void setHotspotStatus(QString interfaceName, QString status);
     void updateNetworkConfig(QString interfaceName, QString optionName, QString newValue);
     void updateMainMenuEntries();
+    void layoutGroup(QString groupId, QStringList interfaces, QHash<QString, QStringList> &members, QHash<QString, QString> &texts);
+    QStringList layoutPages(QString groupId, QStringList oldPages, QStringList interfaces, QHash<QString, QStringList> &members, QHash<QString, QString> &texts);
+    QStringList fillPages(QString groupId, QString pageId, QStringList entries, QHash<QString, QStringList> &members, QHash<QString, QString> &texts);
+    QStringList addPages(QString groupId, QStringList interfaces, QHash<QString, QStringList> &members, QHash<QString, QString> &texts);
+    void addGroupEntry(QString groupId, QString id, QString text);
+    void delGroupEntry(QString groupId, QString id);
+    void populateGroup(QString groupId);
     void updateSubMenuEntries(QString interfaceName);
     void scanAndConnect(QString interfaceName);
+    void clearApList(QString interfaceName);
+    void sortApList(QString interfaceName);
+    void unfreezeApList(QString interfaceName);
+    void apSignalStrengthChanged(QString interfaceName, QString apPath, int strength);
+    void apDisappeared(QString interfaceName, QString apPath);
+    void refreshApList(QString interfaceName);
+    void refreshApLists();
 
     void addMenuItem(QString parent, QString newId, QString rest);
     void delMenuItem(QString parent, QString id);
@@ -0,0 +1,5 @@
+TARGET = tst_aplist
+
+include(../tests.pri)
+
+SOURCES += tst_aplist.cpp
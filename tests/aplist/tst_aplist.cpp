@@ -0,0 +1,190 @@
+#include <QtTest>
+
+#include "FakeLcdClient.hpp"
+#include "FakeLcdd.hpp"
+
+// Follows the signal strength of the APs in a WiFi list and checks the exact
+// commands sent to LCDd: Signal bars with hysteresis, at most one refresh a
+// second, texts only sent when they change and re-sorting without deleting
+// and re-adding entries, except while the user is inside an entry
+class TestApList : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void hysteresis();
+    void rateLimit();
+    void resort();
+    void apDisappeared();
+    void frozen();
+    void unknownInterface();
+
+private:
+    static void scan(FakeLcdd &lcdd, FakeLcdClient &client);
+    static QString setText(int slot, QString text);
+};
+
+void TestApList::initTestCase()
+{
+    QLoggingCategory::setFilterRules("default.debug=false");
+}
+
+// Enter the list of wlan0, with "Alpha" (secured, two APs) on slot 0
+// and "Bravo" (open) on slot 1
+void TestApList::scan(FakeLcdd &lcdd, FakeLcdClient &client)
+{
+    QList<FakeLcdClient::AccessPointInfo> aps;
+    FakeLcdClient::AccessPointInfo ap;
+
+    ap.path = "/ap/1";
+    ap.ssid = "Alpha";
+    ap.secured = true;
+    ap.signalStrength = 80;
+    aps.append(ap);
+    ap.path = "/ap/2";
+    ap.ssid = "Bravo";
+    ap.secured = false;
+    ap.signalStrength = 30;
+    aps.append(ap);
+    ap.path = "/ap/3";
+    ap.ssid = "Alpha";
+    ap.secured = true;
+    ap.signalStrength = 40;
+    aps.append(ap);
+    client.scanResults["wlan0"] = aps;
+
+    lcdd.sendEvent("menuevent enter wlan0_list");
+    QStringList commands = lcdd.takeCommands();
+    QVERIFY(commands.contains("menu_add_item \"wlan0_list\" \"wlan0_list_0\" menu \"####*Alpha\""));
+    QVERIFY(commands.contains("menu_add_item \"wlan0_list\" \"wlan0_list_1\" menu \"#... Bravo\""));
+    QVERIFY(!commands.contains("menu_add_item \"wlan0_list\" \"wlan0_list_2\" menu \"##..*Alpha\""));
+}
+
+QString TestApList::setText(int slot, QString text)
+{
+    return QString("menu_set_item \"\" \"wlan0_list_%1\" -text \"%2\"").arg(slot).arg(text);
+}
+
+// Bars only change once the strength is 5% past a threshold
+void TestApList::hysteresis()
+{
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    scan(lcdd, client);
+
+    client.apSignalStrengthChanged("wlan0", "/ap/2", 44);
+    client.refreshApLists();
+    QCOMPARE(lcdd.takeCommands(), QStringList());
+
+    client.apSignalStrengthChanged("wlan0", "/ap/2", 46);
+    client.refreshApLists();
+    QCOMPARE(lcdd.takeCommands(), QStringList({setText(1, "##.. Bravo")}));
+
+    client.apSignalStrengthChanged("wlan0", "/ap/2", 36);
+    client.refreshApLists();
+    QCOMPARE(lcdd.takeCommands(), QStringList());
+
+    client.apSignalStrengthChanged("wlan0", "/ap/2", 34);
+    client.refreshApLists();
+    QCOMPARE(lcdd.takeCommands(), QStringList({setText(1, "#... Bravo")}));
+}
+
+// Changes are collected and sent once, a second after the first one
+void TestApList::rateLimit()
+{
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    scan(lcdd, client);
+
+    QElapsedTimer timer;
+    timer.start();
+    client.apSignalStrengthChanged("wlan0", "/ap/2", 46);
+    client.apSignalStrengthChanged("wlan0", "/ap/2", 66);
+    client.apSignalStrengthChanged("wlan0", "/ap/2", 55);
+    QVERIFY(client.apListRefreshTimer.isActive());
+    QCOMPARE(lcdd.takeCommands(), QStringList());
+
+    QTRY_VERIFY_WITH_TIMEOUT(!client.apListRefreshTimer.isActive(), 2000);
+    QVERIFY(timer.elapsed() >= 900);
+    QCOMPARE(lcdd.takeCommands(), QStringList({setText(1, "##.. Bravo")}));
+}
+
+// A re-sort only changes the texts of the slots, no entry is deleted or added
+void TestApList::resort()
+{
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    scan(lcdd, client);
+
+    client.apSignalStrengthChanged("wlan0", "/ap/2", 95);
+    client.apSignalStrengthChanged("wlan0", "/ap/1", 20);
+    client.apSignalStrengthChanged("wlan0", "/ap/3", 20);
+    client.refreshApLists();
+    QCOMPARE(lcdd.takeCommands(), QStringList({setText(0, "#### Bravo"), setText(1, "#...*Alpha")}));
+}
+
+// The entry falls back to the other AP with the same SSID
+void TestApList::apDisappeared()
+{
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    scan(lcdd, client);
+
+    client.apDisappeared("wlan0", "/ap/9");
+    client.refreshApLists();
+    QCOMPARE(lcdd.takeCommands(), QStringList());
+
+    client.apDisappeared("wlan0", "/ap/1");
+    client.refreshApLists();
+    QCOMPARE(lcdd.takeCommands(), QStringList({setText(0, "##..*Alpha")}));
+    QCOMPARE(QStringList(client.apLists["wlan0"][0].apStrengths.keys()), QStringList({"/ap/3"}));
+}
+
+// Inside an entry the bars are still updated, but the list is only
+// re-sorted once the user has left it
+void TestApList::frozen()
+{
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    scan(lcdd, client);
+
+    lcdd.sendEvent("menuevent enter wlan0_list_1");
+    QCOMPARE(client.apListSelections.value("wlan0"), QString("Bravo"));
+    lcdd.sendEvent("menuevent enter wlan0_list_0");
+    QCOMPARE(client.apListSelections.value("wlan0"), QString("Alpha"));
+    QVERIFY(client.frozenApLists.contains("wlan0"));
+
+    client.apSignalStrengthChanged("wlan0", "/ap/2", 95);
+    client.apSignalStrengthChanged("wlan0", "/ap/1", 20);
+    client.apSignalStrengthChanged("wlan0", "/ap/3", 20);
+    client.refreshApLists();
+    QCOMPARE(lcdd.takeCommands(), QStringList({setText(0, "#...*Alpha"), setText(1, "#### Bravo")}));
+
+    client.unfreezeApList("wlan0");
+    QVERIFY(!client.apListSelections.contains("wlan0"));
+    client.refreshApLists();
+    QCOMPARE(lcdd.takeCommands(), QStringList({setText(0, "#### Bravo"), setText(1, "#...*Alpha")}));
+}
+
+// Signals for an interface without a list do not create one
+void TestApList::unknownInterface()
+{
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+
+    client.apSignalStrengthChanged("wlan9", "/ap/1", 50);
+    client.apDisappeared("wlan9", "/ap/1");
+    QVERIFY(client.apLists.isEmpty());
+    QVERIFY(!client.apListRefreshTimer.isActive());
+}
+
+QTEST_GUILESS_MAIN(TestApList)
+
+#include "tst_aplist.moc"
@@ -0,0 +1,149 @@
+#include "LcdClient.hpp"
+
+#ifndef FAKELCDCLIENT_H_
+#define FAKELCDCLIENT_H_
+
+// Stands in for the AccessPoint and WirelessDevice signals LcdClient follows
+// after a scan. connections() tells how many of those it still follows
+class FakeAccessPoints : public QObject
+{
+    Q_OBJECT
+
+public:
+    int connections() const
+    {
+        return receivers(SIGNAL(signalStrengthChanged(QString,int))) + receivers(SIGNAL(disappeared(QString)));
+    }
+
+signals:
+    void signalStrengthChanged(QString apPath, int strength);
+    void disappeared(QString apPath);
+};
+
+// LcdClient with a fake device list and fake scan results instead of NetworkManager
+class FakeLcdClient : public LcdClient
+{
+public:
+    explicit FakeLcdClient(quint16 lcdPort)
+        : LcdClient(lcdPort)
+    {
+    }
+
+    using LcdClient::InterfaceInfo;
+    using LcdClient::AccessPointInfo;
+
+    QList<InterfaceInfo> devices;
+    QHash<QString, QList<AccessPointInfo>> scanResults;
+    QHash<QString, QStringList> lastScannedPaths;    // Interface -> APs returned by its last scan
+    FakeAccessPoints accessPoints;
+
+    // Fake hotspot backend: NetworkManager answers the add-and-activate call
+    // after replyDelayMs (or fails it) and reports the connection as
+    // activating, then as activated after another activatingDelayMs
+    WirelessDevice::Capabilities capabilities;
+    int replyDelayMs = 0;
+    int activatingDelayMs = 0;
+    bool failActivation = false;
+    int activations = 0;
+    Connection::Ptr lastHotspotConnection;
+    NMVariantMapMap lastHotspotSettings;
+
+    // An existing hotspot profile of the interface, none if null
+    Connection::Ptr existingHotspot;
+    ConnectionSettings::Ptr existingHotspotSettings;
+
+    using LcdClient::lcdSocket;
+    using LcdClient::menuEntries;
+    using LcdClient::apLists;
+    using LcdClient::apListTexts;
+    using LcdClient::apListConnections;
+    using LcdClient::apListSelections;
+    using LcdClient::frozenApLists;
+    using LcdClient::apListRefreshTimer;
+    using LcdClient::interfaceTexts;
+    using LcdClient::groupMembers;
+    using LcdClient::groupTexts;
+    using LcdClient::populatedGroups;
+    using LcdClient::hotspotStatus;
+    using LcdClient::hotspotTimers;
+    using LcdClient::hotspotStateChanged;
+    using LcdClient::updateMainMenuEntries;
+    using LcdClient::apSignalStrengthChanged;
+    using LcdClient::apDisappeared;
+    using LcdClient::refreshApLists;
+    using LcdClient::unfreezeApList;
+    using LcdClient::addMenuItem;
+
+protected:
+    QList<InterfaceInfo> networkDevices() override
+    {
+        return devices;
+    }
+
+    QList<AccessPointInfo> scanAccessPoints(QString interfaceName) override
+    {
+        AccessPointInfo ap;
+        lastScannedPaths[interfaceName].clear();
+        foreach(ap, scanResults.value(interfaceName)) {
+            lastScannedPaths[interfaceName].append(ap.path);
+        }
+
+        // Follow the APs like LcdClient::scanAccessPoints() does
+        apListConnections[interfaceName].append(
+            connect(&accessPoints, &FakeAccessPoints::signalStrengthChanged, this, [this, interfaceName](QString apPath, int strength) {
+                apSignalStrengthChanged(interfaceName, apPath, strength);
+            }));
+        apListConnections[interfaceName].append(
+            connect(&accessPoints, &FakeAccessPoints::disappeared, this, [this, interfaceName](QString apPath) {
+                apDisappeared(interfaceName, apPath);
+            }));
+
+        return scanResults.value(interfaceName);
+    }
+
+    // The connection entries need NetworkManager, the test devices have none
+    Device::Type addConnectionEntries(QString interfaceName) override
+    {
+        InterfaceInfo info;
+        foreach(info, devices) {
+            if (info.name == interfaceName) {
+                return info.type;
+            }
+        }
+        return Device::UnknownType;
+    }
+
+    WirelessDevice::Capabilities wirelessCapabilities(QString) override
+    {
+        return capabilities;
+    }
+
+    Connection::Ptr findHotspotConnection(QString) override
+    {
+        return existingHotspot;
+    }
+
+    ConnectionSettings::Ptr hotspotSettings(Connection::Ptr) override
+    {
+        return existingHotspotSettings;
+    }
+
+    void activateHotspot(QString interfaceName, Connection::Ptr con, NMVariantMapMap settings) override
+    {
+        activations++;
+        lastHotspotConnection = con;
+        lastHotspotSettings = settings;
+
+        QTimer::singleShot(replyDelayMs, this, [this, interfaceName]() {
+            if (failActivation) {
+                hotspotFailed(interfaceName, "Error: Not added");
+                return;
+            }
+            hotspotStateChanged(interfaceName, ActiveConnection::Activating);
+            QTimer::singleShot(activatingDelayMs, this, [this, interfaceName]() {
+                hotspotStateChanged(interfaceName, ActiveConnection::Activated);
+            });
+        });
+    }
+};
+#endif  // FAKELCDCLIENT_H_
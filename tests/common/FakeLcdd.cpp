@@ -0,0 +1,73 @@
+#include "FakeLcdd.hpp"
+
+// Listen on a free port on localhost, the client is pointed to port()
+FakeLcdd::FakeLcdd(QObject *parent)
+    : QObject(parent), client(nullptr), connection(nullptr), bytesSent(0), bytesReceived(0)
+{
+    server.listen(QHostAddress::LocalHost, 0);
+}
+
+quint16 FakeLcdd::port() const
+{
+    return server.serverPort();
+}
+
+// Wait for the client's socket to connect. Everything it writes is counted
+// from here on, so drain() knows how much still has to arrive
+bool FakeLcdd::accept(QTcpSocket *clientSocket)
+{
+    client = clientSocket;
+    connect(client, &QIODevice::bytesWritten, this, [this](qint64 bytes) {
+        bytesSent += bytes;
+    });
+
+    if (!client->waitForConnected(3000) || !server.waitForNewConnection(3000)) {
+        return false;
+    }
+    connection = server.nextPendingConnection();
+    return connection != nullptr;
+}
+
+// Send a line (e.g. "menuevent enter wlan0_list") and let the client handle it
+void FakeLcdd::sendEvent(QString event)
+{
+    connection->write(QString("%1\n").arg(event).toLatin1());
+    connection->waitForBytesWritten(1000);
+    client->waitForReadyRead(1000);
+}
+
+// Wait for everything the client has written so far and throw it away.
+// Returns the number of commands
+int FakeLcdd::drain()
+{
+    receive();
+    int commands = received.count('\n');
+    received.clear();
+    return commands;
+}
+
+// Wait for everything the client has written so far, one command per line
+QStringList FakeLcdd::takeCommands()
+{
+    receive();
+    QStringList commands = QString::fromLatin1(received).split("\n", QString::SkipEmptyParts);
+    received.clear();
+    return commands;
+}
+
+void FakeLcdd::receive()
+{
+    while (client->bytesToWrite() > 0) {
+        if (!client->waitForBytesWritten(1000)) {
+            break;
+        }
+    }
+    while (bytesReceived < bytesSent) {
+        if ((connection->bytesAvailable() == 0) && !connection->waitForReadyRead(1000)) {
+            break;
+        }
+        QByteArray data = connection->readAll();
+        bytesReceived += data.size();
+        received.append(data);
+    }
+}
@@ -0,0 +1,33 @@
+#include <QtNetwork>
+#include <QtCore>
+
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#ifndef FAKELCDD_H_
+#define FAKELCDD_H_
+
+// A stand-in for LCDd: accepts the connection of one LcdClient, collects
+// the commands it sends and sends menu events back to it
+class FakeLcdd : public QObject
+{
+public:
+    explicit FakeLcdd(QObject *parent = nullptr);
+
+    quint16 port() const;
+    bool accept(QTcpSocket *clientSocket);
+    void sendEvent(QString event);
+    int drain();
+    QStringList takeCommands();
+
+private:
+    QTcpServer server;
+    QTcpSocket *client;
+    QTcpSocket *connection;
+    qint64 bytesSent;
+    qint64 bytesReceived;
+    QByteArray received;
+
+    void receive();
+};
+#endif  // FAKELCDD_H_
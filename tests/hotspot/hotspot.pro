@@ -0,0 +1,5 @@
+TARGET = tst_hotspot
+
+include(../tests.pri)
+
+SOURCES += tst_hotspot.cpp
@@ -0,0 +1,221 @@
+#include <QtTest>
+
+#include "FakeLcdClient.hpp"
+#include "FakeLcdd.hpp"
+
+// Starts hotspots from the "Start NEW AP" menu against a fake NetworkManager
+// and measures the time from START until the connection is activated
+class TestHotspot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void timeToActivated_data();
+    void timeToActivated();
+    void validation_data();
+    void validation();
+    void reuseProfile_data();
+    void reuseProfile();
+    void activationFails();
+    void hotspotStops();
+
+private:
+    void enterOptions(FakeLcdd &lcdd, QString ssid, QString band, QString pass);
+};
+
+void TestHotspot::initTestCase()
+{
+    QLoggingCategory::setFilterRules("default.debug=false");
+}
+
+// What the user enters in the "Start NEW AP" menu, an empty SSID or
+// password is left untouched
+void TestHotspot::enterOptions(FakeLcdd &lcdd, QString ssid, QString band, QString pass)
+{
+    if (!ssid.isEmpty()) {
+        lcdd.sendEvent(QString("menuevent update wlan0_startAP_ssid %1").arg(ssid));
+    }
+    if (!pass.isEmpty()) {
+        lcdd.sendEvent(QString("menuevent update wlan0_startAP_pass %1").arg(pass));
+    }
+    lcdd.sendEvent(QString("menuevent update wlan0_startAP_band %1").arg(band));
+}
+
+void TestHotspot::timeToActivated_data()
+{
+    QTest::addColumn<int>("replyDelayMs");
+    QTest::addColumn<int>("activatingDelayMs");
+
+    QTest::newRow("instant backend") << 0 << 0;
+    QTest::newRow("fast backend") << 50 << 200;
+    QTest::newRow("slow backend") << 300 << 1500;
+}
+
+void TestHotspot::timeToActivated()
+{
+    QFETCH(int, replyDelayMs);
+    QFETCH(int, activatingDelayMs);
+
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    client.capabilities = WirelessDevice::ApCap | WirelessDevice::FreqValid | WirelessDevice::Freq2Ghz | WirelessDevice::Freq5Ghz;
+    client.replyDelayMs = replyDelayMs;
+    client.activatingDelayMs = activatingDelayMs;
+
+    enterOptions(lcdd, "Provisioning", "1", "secret123");
+    lcdd.drain();
+
+    QElapsedTimer timer;
+    timer.start();
+    lcdd.sendEvent("menuevent select wlan0_startAP_start");
+    qint64 startReturnedMs = timer.elapsed();
+
+    // START does not wait for NetworkManager, the progress is shown right away
+    QCOMPARE(client.activations, 1);
+    QVERIFY(lcdd.takeCommands().contains("menu_set_item \"\" \"wlan0_startAP_status\" -text \"Saving ...\""));
+    if (replyDelayMs > 0) {
+        QVERIFY(startReturnedMs < replyDelayMs);
+    }
+
+    QTRY_VERIFY_WITH_TIMEOUT(client.hotspotStatus.value("wlan0").startsWith("Up ("), 5000);
+    qint64 activatedMs = timer.elapsed();
+    QStringList commands = lcdd.takeCommands();
+    QVERIFY(commands.contains("menu_set_item \"\" \"wlan0_startAP_status\" -text \"Starting ...\""));
+
+    // An AP mode profile with shared IPv4 on the chosen band
+    QCOMPARE(client.lastHotspotSettings.value("802-11-wireless").value("mode").toString(), QString("ap"));
+    QCOMPARE(client.lastHotspotSettings.value("802-11-wireless").value("band").toString(), QString("a"));
+    QCOMPARE(client.lastHotspotSettings.value("802-11-wireless").value("ssid").toByteArray(), QByteArray("Provisioning"));
+    QCOMPARE(client.lastHotspotSettings.value("ipv4").value("method").toString(), QString("shared"));
+    QCOMPARE(client.lastHotspotSettings.value("802-11-wireless-security").value("key-mgmt").toString(), QString("wpa-psk"));
+
+    qInfo("backend %4d + %4d ms: START handled in %3lld ms, activated after %5lld ms (%lld ms in the client), status \"%s\"",
+        replyDelayMs, activatingDelayMs, startReturnedMs, activatedMs,
+        activatedMs - replyDelayMs - activatingDelayMs,
+        qPrintable(client.hotspotStatus.value("wlan0")));
+}
+
+void TestHotspot::validation_data()
+{
+    QTest::addColumn<int>("capabilities");
+    QTest::addColumn<QString>("ssid");
+    QTest::addColumn<QString>("band");
+    QTest::addColumn<QString>("pass");
+    QTest::addColumn<QString>("status");
+
+    const int apCap = WirelessDevice::ApCap;
+
+    QTest::newRow("no WiFi device") << 0 << "Provisioning" << "0" << "secret123" << "Error: No WiFi dev";
+    QTest::newRow("no AP mode") << int(WirelessDevice::Wep40 | WirelessDevice::Ccmp) << "Provisioning" << "0" << "secret123" << "Error: No AP mode";
+    QTest::newRow("no 5GHz") << int(WirelessDevice::ApCap | WirelessDevice::FreqValid | WirelessDevice::Freq2Ghz) << "Provisioning" << "1" << "secret123" << "Error: No 5GHz";
+    QTest::newRow("empty SSID") << apCap << "" << "0" << "secret123" << "Error: Bad SSID";
+    QTest::newRow("33 character SSID") << apCap << QString(33, 'S') << "0" << "secret123" << "Error: Bad SSID";
+    QTest::newRow("no password, no profile") << apCap << "Provisioning" << "0" << "" << "Error: Bad password";
+    QTest::newRow("short password") << apCap << "Provisioning" << "0" << "short" << "Error: Bad password";
+    QTest::newRow("64 character password") << apCap << "Provisioning" << "0" << QString(64, 'p') << "Error: Bad password";
+    QTest::newRow("non-ASCII password") << apCap << "Provisioning" << "0" << QString("geheim%1123").arg(QChar(0xa7)) << "Error: Bad password";
+}
+
+// Invalid settings are rejected before NetworkManager is asked at all
+void TestHotspot::validation()
+{
+    QFETCH(int, capabilities);
+    QFETCH(QString, ssid);
+    QFETCH(QString, band);
+    QFETCH(QString, pass);
+    QFETCH(QString, status);
+
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    client.capabilities = WirelessDevice::Capabilities(capabilities);
+
+    enterOptions(lcdd, ssid, band, pass);
+    lcdd.sendEvent("menuevent select wlan0_startAP_start");
+
+    QCOMPARE(client.activations, 0);
+    QCOMPARE(client.hotspotStatus.value("wlan0"), status);
+    QVERIFY(client.hotspotTimers.isEmpty());
+}
+
+void TestHotspot::reuseProfile_data()
+{
+    QTest::addColumn<QString>("pass");
+    QTest::addColumn<QString>("psk");
+
+    QTest::newRow("stored password") << "" << "storedpsk1";
+    QTest::newRow("new password") << "newsecret9" << "newsecret9";
+}
+
+// An existing hotspot profile of the interface is updated and activated
+// instead of adding a new one. Without a new password it keeps its own
+void TestHotspot::reuseProfile()
+{
+    QFETCH(QString, pass);
+    QFETCH(QString, psk);
+
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    client.capabilities = WirelessDevice::ApCap;
+
+    ConnectionSettings::Ptr stored(new ConnectionSettings(ConnectionSettings::Wireless));
+    stored->setId("Hotspot wlan0");
+    stored->setUuid("5c8b1d38-0d6c-4c8e-9a4e-1f2a3b4c5d6e");
+    stored->setInterfaceName("wlan0");
+    WirelessSetting::Ptr wirelessSetting = stored->setting(Setting::Wireless).dynamicCast<WirelessSetting>();
+    wirelessSetting->setSsid("OldName");
+    wirelessSetting->setMode(WirelessSetting::Ap);
+    WirelessSecuritySetting::Ptr wifiSecurity = stored->setting(Setting::WirelessSecurity).dynamicCast<WirelessSecuritySetting>();
+    wifiSecurity->setKeyMgmt(WirelessSecuritySetting::WpaPsk);
+    wifiSecurity->setPsk("storedpsk1");
+    client.existingHotspotSettings = stored;
+    client.existingHotspot = Connection::Ptr(new Connection("/org/freedesktop/NetworkManager/Settings/42"));
+
+    enterOptions(lcdd, "Provisioning", "0", pass);
+    lcdd.sendEvent("menuevent select wlan0_startAP_start");
+
+    QCOMPARE(client.activations, 1);
+    QVERIFY(client.lastHotspotConnection == client.existingHotspot);
+    QCOMPARE(client.lastHotspotSettings.value("connection").value("uuid").toString(), QString("5c8b1d38-0d6c-4c8e-9a4e-1f2a3b4c5d6e"));
+    QCOMPARE(client.lastHotspotSettings.value("802-11-wireless").value("ssid").toByteArray(), QByteArray("Provisioning"));
+    QCOMPARE(client.lastHotspotSettings.value("802-11-wireless-security").value("psk").toString(), psk);
+    QTRY_VERIFY(client.hotspotStatus.value("wlan0").startsWith("Up ("));
+}
+
+void TestHotspot::activationFails()
+{
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    client.capabilities = WirelessDevice::ApCap;
+    client.failActivation = true;
+
+    enterOptions(lcdd, "Provisioning", "0", "secret123");
+    lcdd.sendEvent("menuevent select wlan0_startAP_start");
+
+    QTRY_COMPARE(client.hotspotStatus.value("wlan0"), QString("Error: Not added"));
+    QVERIFY(client.hotspotTimers.isEmpty());
+}
+
+// A hotspot that goes down after it was up does not keep showing "Up"
+void TestHotspot::hotspotStops()
+{
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    client.capabilities = WirelessDevice::ApCap;
+
+    enterOptions(lcdd, "Provisioning", "0", "secret123");
+    lcdd.sendEvent("menuevent select wlan0_startAP_start");
+    QTRY_VERIFY(client.hotspotStatus.value("wlan0").startsWith("Up ("));
+
+    client.hotspotStateChanged("wlan0", ActiveConnection::Deactivated);
+    QCOMPARE(client.hotspotStatus.value("wlan0"), QString("Status: Stopped"));
+}
+
+QTEST_GUILESS_MAIN(TestHotspot)
+
+#include "tst_hotspot.moc"
@@ -0,0 +1,5 @@
+TARGET = tst_mainmenu_bench
+
+include(../tests.pri)
+
+SOURCES += tst_mainmenu_bench.cpp
@@ -0,0 +1,278 @@
+#include <QtTest>
+
+#include "FakeLcdClient.hpp"
+#include "FakeLcdd.hpp"
+
+// Measures the main menu with 8, 10, 100 and 1000 managed Ethernet devices:
+// LCDd commands and time of the first refresh, of entering every group and
+// page, and of the periodic refresh (every 500ms in LcdClient) afterwards,
+// with devices changing their state or coming and going
+class TestMainMenuBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void mainMenu_data();
+    void mainMenu();
+    void churn_data();
+    void churn();
+
+private:
+    static void addDevices(FakeLcdClient &client, int deviceCount);
+    static int enterAll(FakeLcdd &lcdd, FakeLcdClient &client);
+    static void applyCommands(QHash<QString, QStringList> &lcdMenus, QStringList commands);
+};
+
+void TestMainMenuBench::initTestCase()
+{
+    QLoggingCategory::setFilterRules("default.debug=false");
+}
+
+// Physical ports, VLANs, bridges and veths, all managed Ethernet devices
+void TestMainMenuBench::addDevices(FakeLcdClient &client, int deviceCount)
+{
+    for (int i = 0; i < deviceCount; i++) {
+        FakeLcdClient::InterfaceInfo info;
+        info.name = QString("%1%2")
+            .arg(QStringList({"eth", "vlan", "br", "veth"})[i % 4])
+            .arg(i);
+        info.type = Device::Ethernet;
+        info.state = Device::Activated;
+        client.devices.append(info);
+    }
+}
+
+// The user opens every group and page once. Returns the number of page levels
+int TestMainMenuBench::enterAll(FakeLcdd &lcdd, FakeLcdClient &client)
+{
+    QStringList toEnter({"_grp_ethernet"});
+    QHash<QString, int> levels({{"_grp_ethernet", 0}});
+    int pageLevels = 0;
+
+    while (!toEnter.isEmpty()) {
+        QString groupId = toEnter.takeFirst();
+        lcdd.sendEvent(QString("menuevent enter %1").arg(groupId));
+        pageLevels = qMax(pageLevels, levels[groupId]);
+
+        QString entry;
+        foreach(entry, client.groupMembers.value(groupId)) {
+            if (entry.startsWith("_grp_")) {
+                toEnter.append(entry);
+                levels[entry] = levels[groupId] + 1;
+            }
+        }
+    }
+    return pageLevels;
+}
+
+// Keep track of the menus as LCDd has them: parent ("" = main menu) -> entries
+// in the order they were added. Children are always deleted before their parent
+void TestMainMenuBench::applyCommands(QHash<QString, QStringList> &lcdMenus, QStringList commands)
+{
+    QRegularExpression addItem("^menu_add_item \"([^\"]*)\" \"([^\"]*)\"");
+    QRegularExpression delItem("^menu_del_item \"[^\"]*\" \"([^\"]*)\"");
+    QString command;
+
+    foreach(command, commands) {
+        QRegularExpressionMatch match = addItem.match(command);
+        if (match.hasMatch()) {
+            lcdMenus[match.captured(1)].append(match.captured(2));
+            continue;
+        }
+        match = delItem.match(command);
+        if (match.hasMatch()) {
+            QString parent;
+            foreach(parent, lcdMenus.keys()) {
+                if (lcdMenus[parent].removeOne(match.captured(1)) && lcdMenus[parent].isEmpty()) {
+                    lcdMenus.remove(parent);
+                }
+            }
+        }
+    }
+}
+
+void TestMainMenuBench::mainMenu_data()
+{
+    QTest::addColumn<int>("deviceCount");
+    QTest::addColumn<int>("pageLevels");
+
+    QTest::newRow("8 devices") << 8 << 0;
+    QTest::newRow("10 devices") << 10 << 1;
+    QTest::newRow("100 devices") << 100 << 2;
+    QTest::newRow("1000 devices") << 1000 << 3;
+}
+
+void TestMainMenuBench::mainMenu()
+{
+    QFETCH(int, deviceCount);
+    QFETCH(int, pageLevels);
+    const int ticks = 100;
+
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    lcdd.drain();
+    addDevices(client, deviceCount);
+
+    QElapsedTimer timer;
+
+    // First refresh: only the main menu is sent, with the groups or (if there
+    // are only a few) the interfaces themselves
+    timer.start();
+    client.updateMainMenuEntries();
+    qint64 firstNs = timer.nsecsElapsed();
+    int firstCommands = lcdd.drain();
+
+    if (deviceCount <= 8) {
+        QStringList names;
+        FakeLcdClient::InterfaceInfo info;
+        foreach(info, client.devices) {
+            names.append(info.name);
+        }
+        std::sort(names.begin(), names.end());
+        QCOMPARE(client.groupMembers.value(""), names);
+    } else {
+        // Pages are split evenly, the group is not left with just a few of them
+        QCOMPARE(client.groupMembers.value("_grp_ethernet").size(), qMin(8, (deviceCount + 7) / 8));
+    }
+
+    // The user opens every group and page once
+    timer.start();
+    int levels = enterAll(lcdd, client);
+    qint64 populateNs = timer.nsecsElapsed();
+    int populateCommands = lcdd.drain();
+    QCOMPARE(levels, pageLevels);
+
+    QString groupId;
+    foreach(groupId, client.groupMembers.keys()) {
+        QVERIFY2(client.groupMembers[groupId].size() <= 8, qPrintable(groupId));
+    }
+
+    // A refresh without any change must not send anything
+    client.updateMainMenuEntries();
+    QCOMPARE(lcdd.drain(), 0);
+
+    // Periodic refreshes where 1% of the devices change their state
+    int changesPerTick = qMax(1, deviceCount / 100);
+    int steadyCommands = 0;
+    qint64 steadyNs = 0;
+    for (int tick = 0; tick < ticks; tick++) {
+        for (int i = 0; i < changesPerTick; i++) {
+            FakeLcdClient::InterfaceInfo &info = client.devices[(tick * changesPerTick + i) % deviceCount];
+            info.state = (info.state == Device::Activated) ? Device::Disconnected : Device::Activated;
+        }
+
+        timer.start();
+        client.updateMainMenuEntries();
+        steadyNs += timer.nsecsElapsed();
+
+        int commands = lcdd.drain();
+        QVERIFY(commands <= changesPerTick);
+        steadyCommands += commands;
+    }
+
+    qInfo("%5d devices: first refresh %4d commands %8.3f ms | %d page levels, %4d commands %8.3f ms"
+        " | per refresh %6.2f commands %8.3f ms",
+        deviceCount, firstCommands, firstNs / 1e6, levels, populateCommands, populateNs / 1e6,
+        steadyCommands / double(ticks), steadyNs / 1e6 / ticks);
+}
+
+void TestMainMenuBench::churn_data()
+{
+    QTest::addColumn<int>("deviceCount");
+
+    QTest::newRow("10 devices") << 10;
+    QTest::newRow("100 devices") << 100;
+    QTest::newRow("1000 devices") << 1000;
+}
+
+// Containers stopping and starting: Every refresh one veth goes and a new one
+// comes. Only the pages covering their names may change, so the number of
+// commands must not depend on the number of devices, and every menu in LCDd
+// must stay sorted
+void TestMainMenuBench::churn()
+{
+    QFETCH(int, deviceCount);
+    const int ticks = 100;
+
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    addDevices(client, deviceCount);
+
+    QHash<QString, QStringList> lcdMenus;
+    client.updateMainMenuEntries();
+    enterAll(lcdd, client);
+    applyCommands(lcdMenus, lcdd.takeCommands());
+
+    QRandomGenerator random(27);
+    int nextDevice = deviceCount;
+    int churnCommands = 0;
+    int maxCommands = 0;
+    int movedInterfaces = 0;
+    qint64 churnNs = 0;
+    QElapsedTimer timer;
+
+    for (int tick = 0; tick < ticks; tick++) {
+        QList<int> veths;
+        for (int i = 0; i < client.devices.size(); i++) {
+            if (client.devices[i].name.startsWith("veth")) {
+                veths.append(i);
+            }
+        }
+        client.devices.removeAt(veths[random.bounded(veths.size())]);
+
+        FakeLcdClient::InterfaceInfo info;
+        info.name = QString("veth%1").arg(nextDevice++);
+        info.type = Device::Ethernet;
+        info.state = Device::Activated;
+        client.devices.append(info);
+
+        timer.start();
+        client.updateMainMenuEntries();
+        churnNs += timer.nsecsElapsed();
+
+        QStringList commands = lcdd.takeCommands();
+        applyCommands(lcdMenus, commands);
+        churnCommands += commands.size();
+        maxCommands = qMax(maxCommands, commands.size());
+
+        // Interfaces deleted although they still exist are moved or re-sorted
+        QString command;
+        foreach(command, commands) {
+            QString id = command.section('"', 3, 3);
+            if (command.startsWith("menu_del_item") && client.interfaceTexts.contains(id)) {
+                movedInterfaces++;
+            }
+        }
+    }
+
+    // LCDd has the main menu and every page entered so far in the right order
+    QStringList shownGroups = client.populatedGroups.values();
+    shownGroups.append("");
+    QString groupId;
+    foreach(groupId, shownGroups) {
+        QStringList entries = lcdMenus.value(groupId);
+        QString entry;
+        foreach(entry, entries) {
+            if (entry.endsWith("_dummy")) {
+                entries.removeOne(entry);
+            }
+        }
+        QCOMPARE(entries, client.groupMembers.value(groupId));
+    }
+    foreach(groupId, client.groupMembers.keys()) {
+        QVERIFY2(client.groupMembers[groupId].size() <= 8, qPrintable(groupId));
+    }
+
+    qInfo("%5d devices, one veth replaced per refresh: %6.2f commands (at most %d) %8.3f ms,"
+        " %.2f interfaces moved per refresh",
+        deviceCount, churnCommands / double(ticks), maxCommands, churnNs / 1e6 / ticks,
+        movedInterfaces / double(ticks));
+    QVERIFY(churnCommands / ticks < 4 * 8);
+}
+
+QTEST_GUILESS_MAIN(TestMainMenuBench)
+
+#include "tst_mainmenu_bench.moc"
@@ -0,0 +1,5 @@
+TARGET = tst_soak
+
+include(../tests.pri)
+
+SOURCES += tst_soak.cpp
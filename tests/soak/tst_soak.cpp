@@ -0,0 +1,216 @@
+#include <QtTest>
+
+#include <unistd.h>
+
+#include "FakeLcdClient.hpp"
+#include "FakeLcdd.hpp"
+
+// Simulates days of WiFi scans, interfaces coming and going and menu
+// navigation, and checks that neither the client's caches nor its
+// resident memory keep growing
+class TestSoak : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void soak();
+
+private:
+    static long residentKiB();
+};
+
+void TestSoak::initTestCase()
+{
+    // LcdClient logs every command, that would be millions of lines here
+    QLoggingCategory::setFilterRules("default.debug=false");
+}
+
+// Resident set size of this process
+long TestSoak::residentKiB()
+{
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.value(1).toLong() * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+void TestSoak::soak()
+{
+    // One iteration is one minute with a rescan, so these are three days.
+    // Memory is compared between the end of the first half day and the end
+    const int minutes = 3 * 24 * 60;
+    const int warmUpMinutes = 12 * 60;
+    const long allowedGrowthKiB = 2048;
+
+    FakeLcdd lcdd;
+    FakeLcdClient client(lcdd.port());
+    QVERIFY(lcdd.accept(&client.lcdSocket));
+    client.capabilities = WirelessDevice::ApCap;
+
+    QRandomGenerator random(26);
+    QStringList veths;
+    int nextVeth = 0;
+    int nextAp = 0;
+    long warmUpKiB = 0;
+
+    for (int minute = 0; minute < minutes; minute++) {
+        // Interface churn: containers come and go, each with a new veth name
+        for (int i = 0; (i < 3) && !veths.isEmpty(); i++) {
+            veths.removeAt(random.bounded(veths.size()));
+        }
+        while (veths.size() < 40) {
+            veths.append(QString("veth%1").arg(nextVeth++));
+        }
+
+        QStringList wifis;
+        wifis << "wlan0";
+        if ((minute / 10) % 2) {
+            wifis << "wlan1";  // A USB stick that is plugged in and out, see below
+        }
+
+        client.devices.clear();
+        QString name;
+        foreach(name, QStringList() << "eth0" << veths) {
+            FakeLcdClient::InterfaceInfo info;
+            info.name = name;
+            info.type = Device::Ethernet;
+            info.state = (random.bounded(4) == 0) ? Device::Disconnected : Device::Activated;
+            client.devices.append(info);
+        }
+        foreach(name, wifis) {
+            FakeLcdClient::InterfaceInfo info;
+            info.name = name;
+            info.type = Device::Wifi;
+            info.state = Device::Activated;
+            client.devices.append(info);
+        }
+
+        // Every scan sees some of 20 networks, each AP with a new D-Bus path
+        client.scanResults.clear();
+        foreach(name, wifis) {
+            int apCount = 5 + random.bounded(10);
+            for (int i = 0; i < apCount; i++) {
+                FakeLcdClient::AccessPointInfo ap;
+                ap.path = QString("/org/freedesktop/NetworkManager/AccessPoint/%1").arg(nextAp++);
+                ap.ssid = QString("net%1").arg(random.bounded(20));
+                ap.secured = random.bounded(2);
+                ap.signalStrength = random.bounded(101);
+                client.scanResults[name].append(ap);
+            }
+        }
+
+        // Two main menu refreshes and the user looking around
+        client.updateMainMenuEntries();
+        client.updateMainMenuEntries();
+        lcdd.sendEvent("menuevent enter _client_menu_");
+        lcdd.sendEvent("menuevent enter _grp_ethernet");
+        QStringList pages = client.groupMembers.value("_grp_ethernet");
+        lcdd.sendEvent(QString("menuevent enter %1").arg(pages[random.bounded(pages.size())]));
+        lcdd.sendEvent("menuevent enter _grp_wifi");
+
+        // Every WiFi list is opened, the signal of the visible APs
+        // changes and one of them disappears
+        QString wifi;
+        foreach(wifi, wifis) {
+            lcdd.sendEvent(QString("menuevent enter %1").arg(wifi));
+            lcdd.sendEvent(QString("menuevent enter %1_list").arg(wifi));
+            lcdd.sendEvent(QString("menuevent enter %1_list_0").arg(wifi));
+            lcdd.sendEvent(QString("menuevent update %1_list_0_pass secret123").arg(wifi));
+
+            FakeLcdClient::AccessPointInfo ap;
+            foreach(ap, client.scanResults.value(wifi)) {
+                emit client.accessPoints.signalStrengthChanged(ap.path, random.bounded(101));
+            }
+            emit client.accessPoints.disappeared(client.scanResults.value(wifi).first().path);
+        }
+        client.refreshApLists();
+
+        // A hotspot is started on the USB stick while it is plugged in ...
+        if ((minute % 20) == 15) {
+            lcdd.sendEvent("menuevent enter wlan1");
+            lcdd.sendEvent("menuevent update wlan1_startAP_ssid Soak");
+            lcdd.sendEvent("menuevent update wlan1_startAP_pass secret123");
+            lcdd.sendEvent("menuevent select wlan1_startAP_start");
+            QTRY_VERIFY(client.hotspotStatus.value("wlan1").startsWith("Up ("));
+        }
+
+        // ... and everything about it is dropped once it is unplugged
+        if ((minute % 20) == 19) {
+            QVERIFY(client.apListConnections.contains("wlan1"));
+            QVERIFY(client.hotspotStatus.contains("wlan1"));
+        }
+        if (((minute % 20) == 0) && (minute > 0)) {
+            QVERIFY(!client.apLists.contains("wlan1"));
+            QVERIFY(!client.apListConnections.contains("wlan1"));
+            QVERIFY(!client.hotspotStatus.contains("wlan1"));
+            QVERIFY(!client.hotspotTimers.contains("wlan1"));
+            QVERIFY(!client.menuEntries.contains("wlan1"));
+        }
+
+        QVERIFY(lcdd.drain() > 0);
+
+        if (minute == warmUpMinutes) {
+            warmUpKiB = residentKiB();
+        }
+    }
+
+    // All caches only know about interfaces and APs that still exist
+    QStringList currentInterfaces = client.interfaceTexts.keys();
+    QCOMPARE(currentInterfaces.size(), client.devices.size());
+
+    QString key;
+    foreach(key, client.menuEntries.keys()) {
+        if ((key == "_") || key.startsWith("_grp_")) {
+            continue;
+        }
+        QVERIFY2(currentInterfaces.contains(key.split("_")[0]), qPrintable(key));
+    }
+    foreach(key, client.groupMembers.keys() + client.groupTexts.keys() + client.populatedGroups.values()) {
+        QVERIFY2(key.isEmpty() || key.startsWith("_grp_"), qPrintable(key));
+    }
+    QVERIFY(client.groupMembers.size() < 20);
+
+    foreach(key, client.apLists.keys() + client.apListTexts.keys() + client.apListSelections.keys()
+            + client.apListConnections.keys() + client.hotspotStatus.keys() + client.hotspotTimers.keys()) {
+        QVERIFY2(currentInterfaces.contains(key), qPrintable(key));
+    }
+
+    // Only the APs of the last scan per interface are still followed
+    int apConnections = 0;
+    foreach(key, client.apListConnections.keys()) {
+        apConnections += client.apListConnections[key].size();
+    }
+    QCOMPARE(client.accessPoints.connections(), apConnections);
+    QVERIFY(apConnections <= 4);
+
+    QString apPath;
+    foreach(key, client.apLists.keys()) {
+        QVERIFY(client.apLists[key].size() <= 20);
+        for (int slot = 0; slot < client.apLists[key].size(); slot++) {
+            foreach(apPath, client.apLists[key][slot].apStrengths.keys()) {
+                QVERIFY2(client.lastScannedPaths[key].contains(apPath), qPrintable(apPath));
+            }
+        }
+    }
+
+    int menuItems = 0;
+    foreach(key, client.menuEntries.keys()) {
+        menuItems += client.menuEntries[key].size();
+    }
+    qInfo() << "After" << minutes << "minutes:" << menuItems << "menu items," << nextVeth << "veths seen," << nextAp << "APs seen";
+    QVERIFY(menuItems < 500);
+
+    // And resident memory stays flat
+    long endKiB = residentKiB();
+    qInfo() << "RSS after warm-up:" << warmUpKiB << "KiB, at the end:" << endKiB << "KiB";
+    QVERIFY(warmUpKiB > 0);
+    QVERIFY2((endKiB - warmUpKiB) < allowedGrowthKiB,
+        qPrintable(QString("RSS grew by %1 KiB").arg(endKiB - warmUpKiB)));
+}
+
+QTEST_GUILESS_MAIN(TestSoak)
+
+#include "tst_soak.moc"
@@ -0,0 +1,22 @@
+# Common settings of the tests: They build LcdClient.cpp together with
+# fakes for LCDd (tests/common) and the NetworkManager access
+
+CONFIG += console c++11 link_pkgconfig testcase
+CONFIG -= app_bundle
+
+QT += network dbus testlib
+QT -= gui
+
+PKGCONFIG += libnm
+
+INCLUDEPATH = $$[QT_SYSROOT]/usr/include/KF5/NetworkManagerQt $$PWD/.. $$PWD/common
+LIBS += -lKF5NetworkManagerQt
+
+SOURCES += \
+    $$PWD/../LcdClient.cpp \
+    $$PWD/common/FakeLcdd.cpp
+
+HEADERS += \
+    $$PWD/../LcdClient.hpp \
+    $$PWD/common/FakeLcdClient.hpp \
+    $$PWD/common/FakeLcdd.hpp
@@ -0,0 +1,7 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    soak \
+    mainmenu_bench \
+    hotspot \
+    aplist